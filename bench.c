@@ -0,0 +1,254 @@
+/*
+    Converter kernel microbenchmarks
+*/
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "psx_decoder.h"
+#include "settings.h"
+#include "sw_controller.h"
+
+#ifndef BENCH_BATCH
+#define BENCH_BATCH 100  // calls per measurement
+#endif
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 20  // measurements per case (best is taken)
+#endif
+#ifndef BENCH_PASSES
+#define BENCH_PASSES 3  // passes over all cases (best relative time is taken)
+#endif
+
+static uint8_t psx_buf[22];
+// Poll command; comm_psx_pad() bit-reverses the buffer it is given
+static const uint8_t psx_poll[7] = {0x01, 0x42};
+static uint8_t sw_input[SW_INPUT_SIZE];
+static SW_REPORT_t sw_report;
+static uint8_t host_data[SW_REPORT_SIZE];
+
+static void bench_bit_reverse(void) { bit_reverse_array(psx_buf, 21); }
+
+// Needs a pad on the bus (host: mock bus), otherwise this is the ACK timeout
+static void bench_comm_psx_pad(void) {
+  uint8_t send[sizeof(psx_poll)];
+  uint8_t recv[sizeof(psx_poll)];
+
+  memcpy(send, psx_poll, sizeof(send));
+  comm_psx_pad(send, recv, sizeof(send), true);
+}
+
+// Layout chosen through the settings (a BUTTON_LAYOUT build has only one)
+static void bench_button_procon(void) {
+  psx_find_decoder(PSX_CTRLID_DIGITAL)->map(psx_buf, sw_input);
+}
+
+static void bench_button_taiko(void) {
+  psx_find_decoder(PSX_CTRLID_DIGITAL)->map(psx_buf, sw_input);
+}
+
+static void bench_analog(void) {
+  psx_find_decoder(PSX_CTRLID_DUAL_ANALOG)->map(psx_buf, sw_input);
+}
+
+static void bench_build_sw_report(void) {
+  sw_report.len = 0;
+  build_sw_report(&sw_report, 0x30, 0x00, sw_initial_input_report,
+                  sizeof(sw_initial_input_report));
+}
+
+static void bench_build_uart_report(void) {
+  // Subcommand 0x03 (set input report mode) = build_uart_report() only
+  sw_report.len = 0;
+  host_data[0] = 0x01;
+  host_data[10] = 0x03;
+  handle_subcommand(&sw_report, host_data, sizeof(host_data));
+}
+
+static void bench_spi_flash_read(void) {
+  // Stick calibration read (0x603d, 0x12 bytes)
+  sw_report.len = 0;
+  host_data[0] = 0x01;
+  host_data[10] = 0x10;
+  host_data[11] = 0x3d;
+  host_data[12] = 0x60;
+  host_data[15] = 0x12;
+  handle_spi_flash_read(&sw_report, host_data, sizeof(host_data));
+}
+
+static void bench_empty(void) {}
+
+// Reference: CRC-8 over a byte buffer (scalar byte loop with shifts, masks
+// and branches, the same kind of work as the kernels but independent of the
+// converter code)
+static uint8_t reference_buf[16];
+static uint8_t reference_crc;
+
+static void bench_reference(void) {
+  uint8_t crc = reference_crc;
+  int i;
+  int bit;
+
+  for (i = 0; i < sizeof(reference_buf); i++) {
+    crc ^= reference_buf[i];
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  reference_crc = crc;
+}
+
+static const struct {
+  const char *name;
+  void (*func)(void);
+  uint8_t layout;  // g_settings.button_layout while measuring
+  bool needs_pad;
+} bench_cases[BENCH_CASE_COUNT] = {
+    {"bit_reverse_array", bench_bit_reverse, SETTINGS_LAYOUT_PROCON, false},
+    {"comm_psx_pad", bench_comm_psx_pad, SETTINGS_LAYOUT_PROCON, true},
+    {"button_report_procon", bench_button_procon, SETTINGS_LAYOUT_PROCON,
+     false},
+    {"button_report_taiko", bench_button_taiko, SETTINGS_LAYOUT_TAIKO, false},
+    {"analog_packing", bench_analog, SETTINGS_LAYOUT_PROCON, false},
+    {"build_sw_report", bench_build_sw_report, SETTINGS_LAYOUT_PROCON, false},
+    {"build_uart_report", bench_build_uart_report, SETTINGS_LAYOUT_PROCON,
+     false},
+    {"spi_flash_read", bench_spi_flash_read, SETTINGS_LAYOUT_PROCON, false},
+};
+
+static uint32_t measure_batch(const BENCH_CLOCK_t *clock,
+                              void (*func)(void)) {
+  uint32_t start = clock->now();
+  int i;
+
+  for (i = 0; i < BENCH_BATCH; i++) {
+    func();
+  }
+  return (clock->now() - start) & clock->mask;
+}
+
+// Best of BENCH_ROUNDS batches for `func` and for the reference kernel,
+// interleaved so both see the same machine state
+static void measure(const BENCH_CLOCK_t *clock, void (*func)(void),
+                    uint32_t *best, uint32_t *best_reference) {
+  int round;
+
+  *best = UINT32_MAX;
+  *best_reference = UINT32_MAX;
+  for (round = 0; round < BENCH_ROUNDS; round++) {
+    uint32_t elapsed = measure_batch(clock, bench_reference);
+    if (elapsed < *best_reference) *best_reference = elapsed;
+    elapsed = measure_batch(clock, func);
+    if (elapsed < *best) *best = elapsed;
+  }
+}
+
+// Sets the case's layout around measure(), restores the user's
+static void measure_case(const BENCH_CLOCK_t *clock, int i, uint32_t *best,
+                         uint32_t *best_reference) {
+  uint8_t layout = g_settings.button_layout;
+
+  g_settings.button_layout = bench_cases[i].layout;
+  measure(clock, bench_cases[i].func, best, best_reference);
+  g_settings.button_layout = layout;
+}
+
+uint32_t bench_run(const BENCH_CLOCK_t *clock, BENCH_RESULT_t *results,
+                   bool pad) {
+  uint32_t overhead;
+  uint32_t reference;
+  uint32_t best_reference = UINT32_MAX;
+  int pass;
+  int i;
+
+  // Analog pad sample: 5A B1 B2 RX RY LX LY
+  memset(psx_buf, 0, sizeof(psx_buf));
+  psx_buf[0] = 0x5a;
+  psx_buf[1] = PSX_BUTTON1_START | PSX_BUTTON1_LEFT;
+  psx_buf[2] = PSX_BUTTON2_CIRCLE | PSX_BUTTON2_R1;
+  psx_buf[3] = 0x80;
+  psx_buf[4] = 0x7f;
+  psx_buf[5] = 0x12;
+  psx_buf[6] = 0xe0;
+  memset(host_data, 0, sizeof(host_data));
+
+  // Warm up caches / branch predictors (and the clock on a host)
+  for (i = 0; i < BENCH_CASE_COUNT; i++) {
+    results[i].name = bench_cases[i].name;
+    results[i].skipped = bench_cases[i].needs_pad && !pad;
+    results[i].relative = results[i].skipped ? 0 : UINT32_MAX;
+    results[i].ticks = 0;
+    if (!results[i].skipped) measure_case(clock, i, &overhead, &reference);
+  }
+
+  // Passes spread each case over the run: a short disturbance (interrupt,
+  // other process) spoils one pass only
+  for (pass = 0; pass < BENCH_PASSES; pass++) {
+    measure(clock, bench_empty, &overhead, &reference);
+
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+      uint32_t ticks;
+      uint32_t relative;
+      if (results[i].skipped) continue;
+      measure_case(clock, i, &ticks, &reference);
+      ticks = (ticks > overhead) ? ticks - overhead : 0;
+      reference = (reference > overhead) ? reference - overhead : 1;
+      relative =
+          (uint32_t)(((uint64_t)ticks * 1000 + reference / 2) / reference);
+      if (relative < results[i].relative) {
+        results[i].relative = relative;
+        results[i].ticks = (ticks + BENCH_BATCH / 2) / BENCH_BATCH;
+      }
+      if (reference < best_reference) best_reference = reference;
+    }
+  }
+  best_reference = (best_reference + BENCH_BATCH / 2) / BENCH_BATCH;
+  return best_reference ? best_reference : 1;
+}
+
+bool bench_slower(const BENCH_CLOCK_t *clock, const BENCH_RESULT_t *result,
+                  uint32_t reference, uint32_t baseline,
+                  int threshold_percent) {
+  // Tiny kernels are close to the timer resolution: never fail on less
+  // than clock->floor ticks, whatever the percentage allows
+  uint32_t floor = (clock->floor * 1000 + reference - 1) / reference;
+  uint32_t slack = baseline * threshold_percent / 100;
+
+  if (baseline == 0 || result->skipped) return false;
+  return result->relative > baseline + (slack > floor ? slack : floor);
+}
+
+int bench_report(const BENCH_CLOCK_t *clock, const BENCH_RESULT_t *results,
+                 uint32_t reference, const uint32_t *baseline,
+                 int threshold_percent) {
+  int failed = 0;
+  int i;
+
+  printf("bench: %-22s %6lu %s\n", "(reference)", (unsigned long)reference,
+         clock->unit);
+  for (i = 0; i < BENCH_CASE_COUNT; i++) {
+    const char *verdict = "-";
+    uint32_t base = (baseline != NULL) ? baseline[i] : 0;
+
+    if (results[i].skipped) {
+      verdict = "skipped (needs a pad)";
+    } else if (base != 0) {
+      if (bench_slower(clock, &results[i], reference, base,
+                       threshold_percent)) {
+        verdict = "SLOWER";
+        failed++;
+      } else {
+        verdict = "ok";
+      }
+    }
+    printf("bench: %-22s %6lu %s %6lu/1000 ref (baseline %lu) %s\n",
+           results[i].name, (unsigned long)results[i].ticks, clock->unit,
+           (unsigned long)results[i].relative, (unsigned long)base, verdict);
+  }
+  printf("bench: %d regression(s)\n", failed);
+
+  return failed;
+}
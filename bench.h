@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Converter kernel microbenchmarks
+// Runs on the target (KERNEL_BENCH build, SysTick cycles) and natively on
+// Linux (tools/bench, nanoseconds).
+// Baselines are relative to a fixed reference kernel measured in the same
+// run (per mille), so they do not depend on the speed of the machine.
+
+#define BENCH_CASE_COUNT 8
+#define BENCH_THRESHOLD_PERCENT 20  // allowed slowdown against baseline
+
+typedef struct {
+  uint32_t (*now)(void);  // free running tick counter
+  uint32_t mask;          // counter width (tick difference is masked)
+  const char *unit;
+  uint32_t floor;  // allowed slowdown of any kernel at least (ticks/call)
+} BENCH_CLOCK_t;
+
+typedef struct {
+  const char *name;
+  uint32_t ticks;     // best per-call time over all rounds
+  uint32_t relative;  // ticks per mille of the reference kernel
+  bool skipped;       // needs a pad on the bus and none answered
+} BENCH_RESULT_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns the reference kernel time (ticks/call)
+// `pad`: a pad answers on the bus (comm_psx_pad is skipped otherwise)
+uint32_t bench_run(const BENCH_CLOCK_t *clock, BENCH_RESULT_t *results,
+                   bool pad);
+// Slower than baseline + threshold (baseline 0: never)
+bool bench_slower(const BENCH_CLOCK_t *clock, const BENCH_RESULT_t *result,
+                  uint32_t reference, uint32_t baseline,
+                  int threshold_percent);
+// Prints results; returns number of cases slower than baseline + threshold
+// (baseline: relative values, 0 = not recorded, not compared)
+int bench_report(const BENCH_CLOCK_t *clock, const BENCH_RESULT_t *results,
+                 uint32_t reference, const uint32_t *baseline,
+                 int threshold_percent);
+
+#ifdef KERNEL_BENCH
+void kernel_bench_target(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+    Kernel benchmark, on-target run (KERNEL_BENCH build)
+*/
+
+#include "bench.h"
+
+#ifdef KERNEL_BENCH
+
+#include <stdio.h>
+
+#include "hardware/structs/systick.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+
+// Baseline per mille of the reference kernel (0 = not recorded yet)
+// Update from the "/1000 ref" column printed by a known good build
+// (with a pad connected). A case without a baseline fails the run, so an
+// unfilled table cannot pass as "no regression".
+static const uint32_t bench_target_baseline[BENCH_CASE_COUNT] = {
+    0,  // bit_reverse_array
+    0,  // comm_psx_pad
+    0,  // button_report_procon
+    0,  // button_report_taiko
+    0,  // analog_packing
+    0,  // build_sw_report
+    0,  // build_uart_report
+    0,  // spi_flash_read
+};
+
+// SysTick counts down from 0xffffff at CPU clock
+static uint32_t systick_now(void) { return 0xffffff - systick_hw->cvr; }
+
+void kernel_bench_target(void) {
+  BENCH_CLOCK_t clock = {systick_now, 0xffffff, "cycles", 4};
+  BENCH_RESULT_t results[BENCH_CASE_COUNT];
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  uint32_t reference;
+  int failed;
+  int i;
+
+  systick_hw->rvr = 0xffffff;
+  systick_hw->cvr = 0;
+  systick_hw->csr = 0x5;  // enable, processor clock
+
+  // Bus timing is only meaningful with a pad answering
+  get_psx_pad_data(psx_recv, &pad_id);
+  get_psx_pad_data(psx_recv, &pad_id);  // new ID needs two polls
+  reference = bench_run(&clock, results, pad_id != PSX_CTRLID_INVALID);
+  failed = bench_report(&clock, results, reference, bench_target_baseline,
+                        BENCH_THRESHOLD_PERCENT);
+  for (i = 0; i < BENCH_CASE_COUNT; i++) {
+    if (!results[i].skipped && bench_target_baseline[i] == 0) {
+      printf("bench: %s has no baseline in bench_target.c\n",
+             results[i].name);
+      failed++;
+    }
+  }
+  if (failed != 0) {
+    // Regression: LED on
+    gpio_init(25);
+    gpio_set_dir(25, GPIO_OUT);
+    gpio_put(25, 1);
+  }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+// Button layouts (declarative)
+// psx_decoder.c turns each table into a straight-line mapping function at
+// compile time: every row becomes one constant shift, no branches.
+// cmake -DBUTTON_LAYOUT=PROCON or TAIKO keeps a single layout and drops the
+// runtime selection (settings / MODE pin).
+
+// Button rows: X(PSX byte, PSX button, Switch byte, Switch bit)
+
+// Normal Pro-con mode
+#define LAYOUT_PROCON_BUTTONS(X)                      \
+  X(2, PSX_BUTTON2_CIRCLE, 0, SW_REP0_BITPOS_A)       \
+  X(2, PSX_BUTTON2_CROSS, 0, SW_REP0_BITPOS_B)        \
+  X(2, PSX_BUTTON2_TRIANGLE, 0, SW_REP0_BITPOS_X)     \
+  X(2, PSX_BUTTON2_RECT, 0, SW_REP0_BITPOS_Y)         \
+  X(2, PSX_BUTTON2_R2, 0, SW_REP0_BITPOS_ZR)          \
+  X(2, PSX_BUTTON2_R1, 0, SW_REP0_BITPOS_R)           \
+  X(1, PSX_BUTTON1_SELECT, 1, SW_REP1_BITPOS_HOME)    \
+  X(1, PSX_BUTTON1_START, 1, SW_REP1_BITPOS_PLUS)     \
+  X(1, PSX_BUTTON1_L3, 1, SW_REP1_BITPOS_THUMBL)      \
+  X(1, PSX_BUTTON1_R3, 1, SW_REP1_BITPOS_THUMBR)      \
+  X(1, PSX_BUTTON1_DOWN, 2, SW_REP2_BITPOS_DOWN)      \
+  X(1, PSX_BUTTON1_UP, 2, SW_REP2_BITPOS_UP)          \
+  X(1, PSX_BUTTON1_RIGHT, 2, SW_REP2_BITPOS_RIGHT)    \
+  X(1, PSX_BUTTON1_LEFT, 2, SW_REP2_BITPOS_LEFT)      \
+  X(2, PSX_BUTTON2_L1, 2, SW_REP2_BITPOS_L)           \
+  X(2, PSX_BUTTON2_L2, 2, SW_REP2_BITPOS_ZL)
+
+// Tata-con mode
+// Tata-con    ML      MR   TL     TR    ST   SEL
+// PSX         LEFT    O    L1     R1    ST   SEL
+// Switch      RIGHT   B    LEFT   A     DOWN HOME
+#define LAYOUT_TAIKO_BUTTONS(X)                       \
+  X(2, PSX_BUTTON2_CIRCLE, 0, SW_REP0_BITPOS_B)       \
+  X(2, PSX_BUTTON2_R1, 0, SW_REP0_BITPOS_A)           \
+  X(1, PSX_BUTTON1_SELECT, 1, SW_REP1_BITPOS_HOME)    \
+  X(1, PSX_BUTTON1_START, 2, SW_REP2_BITPOS_DOWN)     \
+  X(1, PSX_BUTTON1_LEFT, 2, SW_REP2_BITPOS_RIGHT)     \
+  X(2, PSX_BUTTON2_L1, 2, SW_REP2_BITPOS_LEFT)
+
+// Analog sticks (same in both layouts)
+// X(Switch stick offset, PSX X byte, X xor, PSX Y byte, Y xor)
+// 8bit PSX value (xor 0xff = inverted) -> upper 8 bits of the 12bit axis
+// psx 3: X2, psx 4: Y2, psx 5: X1, psx 6: Y1 (PSX Y grows downwards)
+#define LAYOUT_STICKS(X) \
+  X(3, 5, 0x00, 6, 0xff) \
+  X(6, 3, 0x00, 4, 0xff)
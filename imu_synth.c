@@ -0,0 +1,121 @@
+/*
+    Synthesized 6-axis motion
+
+    Samples are placed at 1/2, 3/2 and 5/2 sample periods after a report,
+    so they always fall between two reports. Each sample is packed into
+    the report byte layout as soon as it is taken (oldest first).
+*/
+
+#include "imu_synth.h"
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "settings.h"
+#include "sw_controller.h"
+
+#define SAMPLE_SIZE (SW_IMU_SIZE / SW_IMU_SAMPLES)
+
+static uint8_t stick_x = 0x80;
+static uint8_t stick_y = 0x80;
+static bool modifier = false;
+static bool have_sticks = false;
+
+static uint8_t samples[SW_IMU_SIZE];
+static bool samples_clear = true;
+static uint32_t report_us = 0;
+static uint8_t taken = SW_IMU_SAMPLES;  // samples since the last report
+
+static inline void update_pad(const uint8_t *psx_recv) {
+  stick_x = psx_recv[3];
+  stick_y = psx_recv[4];
+  modifier = psx_recv[1] & PSX_BUTTON1_R3;
+}
+
+void imu_synth_pad(const uint8_t *psx_recv) { update_pad(psx_recv); }
+
+static inline bool motion_active(void) {
+  switch (g_settings.imu_mode) {
+    case SETTINGS_IMU_STICK:
+      return have_sticks;
+    case SETTINGS_IMU_R3:
+      return have_sticks && modifier;
+    default:
+      return false;
+  }
+}
+
+static int16_t stick_rate(uint8_t value) {
+  int d = value - 0x80;
+
+  if (d > -IMU_STICK_DEADZONE && d < IMU_STICK_DEADZONE) return 0;
+  return d * IMU_GYRO_GAIN;
+}
+
+static void put_int16(uint8_t *out, int16_t value) {
+  out[0] = value & 0xff;
+  out[1] = (uint16_t)value >> 8;
+}
+
+static void take_sample(void) {
+  uint8_t *sample = samples + SW_IMU_SIZE - SAMPLE_SIZE;
+  int16_t yaw = 0;
+  int16_t pitch = 0;
+
+  if (motion_active()) {
+    // Stick right: turn right (negative yaw), stick up (PSX Y small): tilt up
+    yaw = -stick_rate(stick_x);
+    pitch = -stick_rate(stick_y);
+  }
+
+  memmove(samples, samples + SAMPLE_SIZE, SW_IMU_SIZE - SAMPLE_SIZE);
+  put_int16(sample + 0, 0);  // accel X
+  put_int16(sample + 2, 0);  // accel Y
+  put_int16(sample + 4, IMU_ACCEL_1G);
+  put_int16(sample + 6, 0);  // gyro X (roll)
+  put_int16(sample + 8, pitch);
+  put_int16(sample + 10, yaw);
+  sw_update_imu(samples);
+}
+
+void imu_synth_task(void) {
+  if (g_settings.imu_mode == SETTINGS_IMU_OFF) {
+    // Back to an empty IMU section
+    if (!samples_clear) {
+      memset(samples, 0, sizeof(samples));
+      sw_update_imu(samples);
+      samples_clear = true;
+    }
+    return;
+  }
+  if (taken >= SW_IMU_SAMPLES) return;
+
+  uint32_t period_us = g_settings.report_interval_ms * 1000 / SW_IMU_SAMPLES;
+
+  if (time_us_32() - report_us >= period_us / 2 + taken * period_us) {
+    take_sample();
+    samples_clear = false;
+    taken++;
+  }
+}
+
+void __not_in_flash_func(imu_synth_report)(const uint8_t *psx_recv,
+                                           bool sticks, uint8_t *sw_input) {
+  report_us = time_us_32();
+  taken = 0;
+
+  have_sticks = sticks;
+  if (!sticks) return;
+  update_pad(psx_recv);
+
+  if (motion_active()) {
+    // Right stick center (0x7f0, 0x7f0)
+    sw_input[6] = 0xf0;
+    sw_input[7] = 0x07;
+    sw_input[8] = 0x7f;
+    if (g_settings.imu_mode == SETTINGS_IMU_R3) {
+      sw_input[1] &= ~(1 << SW_REP1_BITPOS_THUMBR);
+    }
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Synthesized 6-axis motion (settings imu_mode)
+// Right stick deflection becomes gyro rates (stick X -> yaw, stick Y ->
+// pitch) of a controller lying flat (gravity on +Z), for games that aim
+// with motion. SW_IMU_SAMPLES samples are taken per report interval on a
+// sub-report timer between reports; the report only copies them.
+// Scale matches the calibration in spi_factory_calib_data (0x6020).
+
+#define IMU_STICK_DEADZONE 10  // PSX counts around center
+#define IMU_GYRO_GAIN 40       // gyro counts per PSX count (about 2.8 dps)
+#define IMU_ACCEL_1G 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latest pad data with sticks (between-report polls)
+void imu_synth_pad(const uint8_t *psx_recv);
+// Sub-report sample timer (main loop, between reports)
+void imu_synth_task(void);
+// At each report: restart the sample timer; while the right stick drives
+// the gyro, report it centered (and R3 released in R3 mode)
+void imu_synth_report(const uint8_t *psx_recv, bool sticks,
+                      uint8_t *sw_input);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,293 @@
+/*
+    PC-streamed input injection (jitter buffer side)
+
+    Frames carry a presentation time on the PC clock. The PC timeline is
+    mapped onto time_us_32() with an offset: the first frame is shown
+    INJECT_START_DELAY_US after it arrives, then once per window the offset
+    is moved so that the earliest arrival keeps INJECT_TARGET_SLACK_US of
+    margin. This absorbs bursty delivery and clock drift between both ends.
+    The drift itself is measured (slack change not caused by the last
+    correction, clamped to INJECT_MAX_DRIFT_US so one stall does not count)
+    and cancelled, so a constant clock error settles at the target margin.
+*/
+
+#include "input_inject.h"
+
+#include <string.h>
+
+#ifdef INPUT_INJECT
+
+#include "hardware/uart.h"
+#include "pico/stdlib.h"
+#include "psx_decoder.h"
+
+#define INJECT_MAX_PAYLOAD 32
+
+// Receive state
+enum { RX_SYNC0, RX_SYNC1, RX_TYPE, RX_LENGTH, RX_PAYLOAD, RX_CHECK };
+
+static uint8_t rx_state = RX_SYNC0;
+static uint8_t rx_type;
+static uint8_t rx_length;
+static uint8_t rx_pos;
+static uint8_t rx_check;
+static uint8_t rx_payload[INJECT_MAX_PAYLOAD];
+
+// Jitter buffer (main loop only)
+static INJECT_FRAME_t buffer[INJECT_BUFFER_SIZE];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+
+static bool active = false;
+static uint32_t offset_us;  // local time = PC time + offset
+static uint32_t last_rx_us;
+static uint32_t last_frame_us;
+static uint8_t current[SW_INPUT_SIZE];
+static bool have_current;
+
+// Drift servo
+static int32_t min_slack_us;
+static uint32_t window_start_us;
+static int32_t rate_us;        // measured drift per window
+static int32_t expect_slack_us;  // next window's error without drift
+static bool have_expect;
+
+static INJECT_STATS_t stats;
+
+// Stats packet being sent, kept across calls
+static uint8_t tx_packet[5 + sizeof(INJECT_STATS_t)];
+static uint8_t tx_len = 0;
+static uint8_t tx_pos = 0;
+static uint32_t stats_us = 0;
+
+void input_inject_init(void) {
+  uart_init(INJECT_UART, INJECT_BAUD_RATE);
+  gpio_set_function(INJECT_PIN_TX, GPIO_FUNC_UART);
+  gpio_set_function(INJECT_PIN_RX, GPIO_FUNC_UART);
+  // Idle high when no PC is connected
+  gpio_set_pulls(INJECT_PIN_RX, true, false);
+}
+
+static void stop(void) {
+  active = false;
+  head = tail = 0;
+}
+
+static void start(const INJECT_FRAME_t *frame, uint32_t now) {
+  active = true;
+  head = tail = 0;
+  have_current = false;
+  offset_us = now - frame->time_us + INJECT_START_DELAY_US;
+  min_slack_us = INT32_MAX;
+  window_start_us = now;
+  rate_us = 0;
+  have_expect = false;
+}
+
+static void receive_frame(const INJECT_FRAME_t *frame, uint32_t now) {
+  stats.received++;
+
+  // Time going backwards: the PC restarted its script
+  if (!active || (int32_t)(frame->time_us - last_frame_us) < 0) {
+    start(frame, now);
+  }
+  last_rx_us = now;
+  last_frame_us = frame->time_us;
+
+  int32_t slack = (int32_t)(frame->time_us + offset_us - now);
+  if (slack < 0) stats.late++;
+  if (slack < min_slack_us) min_slack_us = slack;
+
+  if (head - tail >= INJECT_BUFFER_SIZE) {
+    stats.overflows++;
+    return;
+  }
+  buffer[head & (INJECT_BUFFER_SIZE - 1)] = *frame;
+  head++;
+}
+
+static void receive_packet(uint32_t now) {
+  INJECT_FRAME_t frame;
+
+  switch (rx_type) {
+    case INJECT_PKT_FRAME:
+      if (rx_length != sizeof(frame)) break;
+      memcpy(&frame, rx_payload, sizeof(frame));
+      receive_frame(&frame, now);
+      return;
+
+    case INJECT_PKT_STOP:
+      stop();
+      return;
+  }
+  stats.bad_packets++;
+}
+
+static void receive_byte(uint8_t data, uint32_t now) {
+  switch (rx_state) {
+    case RX_SYNC0:
+      if (data == INJECT_SYNC0) rx_state = RX_SYNC1;
+      break;
+
+    case RX_SYNC1:
+      rx_state = (data == INJECT_SYNC1) ? RX_TYPE : RX_SYNC0;
+      break;
+
+    case RX_TYPE:
+      rx_type = data;
+      rx_check = data;
+      rx_state = RX_LENGTH;
+      break;
+
+    case RX_LENGTH:
+      if (data > INJECT_MAX_PAYLOAD) {
+        stats.bad_packets++;
+        rx_state = RX_SYNC0;
+        break;
+      }
+      rx_length = data;
+      rx_check ^= data;
+      rx_pos = 0;
+      rx_state = (data > 0) ? RX_PAYLOAD : RX_CHECK;
+      break;
+
+    case RX_PAYLOAD:
+      rx_payload[rx_pos++] = data;
+      rx_check ^= data;
+      if (rx_pos == rx_length) rx_state = RX_CHECK;
+      break;
+
+    case RX_CHECK:
+      if (data == rx_check) {
+        receive_packet(now);
+      } else {
+        stats.bad_packets++;
+      }
+      rx_state = RX_SYNC0;
+      break;
+  }
+}
+
+const INJECT_STATS_t *input_inject_stats(void) {
+  stats.depth = head - tail;
+  stats.active = active;
+  return &stats;
+}
+
+static void build_stats_packet(void) {
+  uint8_t check;
+  int i;
+
+  input_inject_stats();
+
+  tx_packet[0] = INJECT_SYNC0;
+  tx_packet[1] = INJECT_SYNC1;
+  tx_packet[2] = INJECT_PKT_STATS;
+  tx_packet[3] = sizeof(stats);
+  memcpy(&tx_packet[4], &stats, sizeof(stats));
+
+  check = 0;
+  for (i = 2; i < 4 + (int)sizeof(stats); i++) check ^= tx_packet[i];
+  tx_packet[4 + sizeof(stats)] = check;
+
+  tx_len = sizeof(tx_packet);
+  tx_pos = 0;
+}
+
+void input_inject_task(void) {
+  uint32_t now = time_us_32();
+
+  while (uart_is_readable(INJECT_UART)) {
+    receive_byte(uart_getc(INJECT_UART), now);
+  }
+
+  if (active && now - window_start_us >= INJECT_DRIFT_WINDOW_US) {
+    if (min_slack_us != INT32_MAX) {
+      int32_t error = min_slack_us - INJECT_TARGET_SLACK_US;
+      int32_t correction;
+
+      if (have_expect) {
+        int32_t drift = error - expect_slack_us;
+
+        if (drift > INJECT_MAX_DRIFT_US) drift = INJECT_MAX_DRIFT_US;
+        if (drift < -INJECT_MAX_DRIFT_US) drift = -INJECT_MAX_DRIFT_US;
+        rate_us += (drift - rate_us) / 4;
+      }
+      correction = error / 4 + rate_us;
+      offset_us -= correction;
+      stats.drift_us -= correction;
+      expect_slack_us = error - correction;
+      have_expect = true;
+    } else {
+      have_expect = false;
+    }
+    min_slack_us = INT32_MAX;
+    window_start_us = now;
+  }
+
+  // Stats go out without blocking, one FIFO slot at a time
+  if (tx_pos == tx_len && now - stats_us >= INJECT_STATS_INTERVAL_US) {
+    stats_us = now;
+    build_stats_packet();
+  }
+  while (tx_pos < tx_len && uart_is_writable(INJECT_UART)) {
+    uart_putc_raw(INJECT_UART, tx_packet[tx_pos++]);
+  }
+}
+
+bool __not_in_flash_func(input_inject_pad_active)(const uint8_t *psx_recv,
+                                                  bool sticks,
+                                                  uint8_t deadzone) {
+  int threshold = (deadzone > INJECT_PAD_STICK_MIN) ? deadzone
+                                                    : INJECT_PAD_STICK_MIN;
+  int i;
+
+  if (psx_recv[1] | psx_recv[2]) return true;
+  if (!sticks) return false;
+  for (i = 3; i < 7; i++) {
+    int d = psx_recv[i] - 0x80;
+    if (d > threshold || d < -threshold) return true;
+  }
+  return false;
+}
+
+bool __not_in_flash_func(input_inject_apply)(uint8_t *sw_input,
+                                             bool pad_active) {
+  if (!active) return false;
+
+  uint32_t now = time_us_32();
+  uint32_t pc_now = now - offset_us;
+  int popped = 0;
+
+  // Latest frame due at this report wins
+  while (tail != head &&
+         (int32_t)(buffer[tail & (INJECT_BUFFER_SIZE - 1)].time_us - pc_now) <=
+             0) {
+    memcpy(current, buffer[tail & (INJECT_BUFFER_SIZE - 1)].input,
+           SW_INPUT_SIZE);
+    tail++;
+    popped++;
+  }
+
+  if (popped > 0) {
+    have_current = true;
+    stats.played++;
+    stats.skipped += popped - 1;
+  } else if (tail == head) {
+    if (now - last_rx_us >= INJECT_TIMEOUT_US) {
+      stop();
+      return false;
+    }
+    stats.underruns++;  // repeat the last frame
+  }
+
+  if (!have_current) return false;  // first frame not due yet
+  if (pad_active) {
+    stats.overrides++;
+    return false;
+  }
+  memcpy(sw_input, current, SW_INPUT_SIZE);
+  return true;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PC-streamed input injection (INPUT_INJECT build, Switch mode)
+// A PC sends timestamped Switch input frames on UART1. They are held in a
+// jitter buffer and replace the pad input at the report whose time is due
+// on the PC timeline. Stream stopped / timed out, or the pad in use (button
+// held, stick pushed): the physical pad is used again at the next report.
+// Send with tools/inject.
+
+#define INJECT_UART uart1
+#define INJECT_PIN_TX 8
+#define INJECT_PIN_RX 9
+#define INJECT_BAUD_RATE 115200
+
+#define INJECT_BUFFER_SIZE 32         // frames, must be power of 2
+#define INJECT_START_DELAY_US 30000   // initial buffer depth
+#define INJECT_TARGET_SLACK_US 6000   // drift servo: min earliness wanted
+#define INJECT_DRIFT_WINDOW_US 1000000
+#define INJECT_MAX_DRIFT_US 2000      // per window (2000 ppm)
+#define INJECT_TIMEOUT_US 200000      // no frame: back to the pad
+#define INJECT_STATS_INTERVAL_US 1000000
+#define INJECT_PAD_STICK_MIN 24  // stick counts from center = pad in use
+
+// Wire format (both directions):
+//   INJECT_SYNC0 INJECT_SYNC1 type length payload[length] xor(type..payload)
+#define INJECT_SYNC0 0xa5
+#define INJECT_SYNC1 0x49
+
+#define INJECT_PKT_FRAME 0x01  // PC -> converter: INJECT_FRAME_t
+#define INJECT_PKT_STOP 0x02   // PC -> converter: no payload
+#define INJECT_PKT_STATS 0x81  // converter -> PC: INJECT_STATS_t
+
+typedef struct __attribute__((packed)) {
+  uint32_t time_us;   // presentation time on the PC timeline
+  uint8_t input[9];   // buttons[3], left stick[3], right stick[3]
+} INJECT_FRAME_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t received;
+  uint32_t played;     // frames sent in a report
+  uint32_t skipped;    // due at the same report as a newer frame
+  uint32_t late;       // arrived after their presentation time
+  uint32_t underruns;  // report with no frame left in the buffer
+  uint32_t overflows;  // buffer full, frame dropped
+  uint32_t bad_packets;
+  uint32_t overrides;  // reports taken over by the physical pad
+  int32_t drift_us;    // total drift correction
+  uint8_t depth;       // frames buffered
+  uint8_t active;
+} INJECT_STATS_t;
+
+#ifdef INPUT_INJECT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void input_inject_init(void);
+// UART receive / stats (main loop)
+void input_inject_task(void);
+// Pad in use: a button held, or (`sticks`) a stick beyond the deadzone
+// and INJECT_PAD_STICK_MIN
+bool input_inject_pad_active(const uint8_t *psx_recv, bool sticks,
+                             uint8_t deadzone);
+// At each report: replace `sw_input` (SW_INPUT_SIZE) with the frame due now
+// true if replaced; `pad_active`: pad in use (pad wins)
+bool input_inject_apply(uint8_t *sw_input, bool pad_active);
+// Counters as sent in INJECT_PKT_STATS
+const INJECT_STATS_t *input_inject_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -33,11 +33,22 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bench.h"
 #include "bsp/board.h"
 #include "hardware/spi.h"
+#include "imu_synth.h"
+#include "input_inject.h"
 #include "pico/stdlib.h"
+#include "pc_controller.h"
 #include "psx_controller.h"
+#include "psx_decoder.h"
+#include "psx_sniffer.h"
+#include "recovery.h"
+#include "settings.h"
+#include "stick_filter.h"
 #include "sw_controller.h"
+#include "sw_state.h"
+#include "trace_log.h"
 #include "tusb.h"
 
 //--------------------------------------------------------------------+
@@ -46,12 +57,58 @@
 void hid_task(void);
 
 bool g_input_enable = false;
+uint8_t g_usb_mode = USB_MODE_SWITCH;
 
-// PSX SPI communication speed
-#define SPI_SPEED_KHZ 250
+static STICK_FILTER_t stick_filter;
+// Device at the last report has analog sticks: only then is the pad read
+// between reports (a mouse would lose the deltas of those reads)
+static bool pad_has_sticks = false;
+// Pad ID the filter history was taken with
+static uint8_t filter_id = PSX_CTRLID_INVALID;
+
+//--------------------------------------------------------------------+
+// Boot phase timestamps (us since power-up)
+//--------------------------------------------------------------------+
+enum {
+  BOOT_PHASE_MAIN = 0,     // main() entered
+  BOOT_PHASE_BOARD_INIT,   // board_init() done
+  BOOT_PHASE_IO_INIT,      // PSX port ready
+  BOOT_PHASE_USB_INIT,     // tusb_init() done (attached)
+  BOOT_PHASE_MOUNT,        // host set configuration
+  BOOT_PHASE_HANDSHAKE,    // first output report from host
+  BOOT_PHASE_INPUT_ENABLE, // 0x80 0x04 received
+  BOOT_PHASE_FIRST_INPUT,  // first 0x30 input queued
+  BOOT_PHASE_COUNT
+};
+
+static uint32_t boot_time_us[BOOT_PHASE_COUNT];
+
+static inline void boot_phase(int phase) {
+  if (boot_time_us[phase] == 0) {
+    boot_time_us[phase] = time_us_32();
+  }
+}
+
+#ifdef BOOT_TIMING
+static void print_boot_timing(void) {
+  static const char *const names[BOOT_PHASE_COUNT] = {
+      "main", "board_init", "io_init", "usb_init",
+      "mount", "handshake", "input_enable", "first_input"};
+  int i;
+
+  for (i = 0; i < BOOT_PHASE_COUNT; i++) {
+    printf("boot: %-12s %8lu us\n", names[i], (unsigned long)boot_time_us[i]);
+  }
+  if (recovery_status()->watchdog_resets > 0) {
+    printf("boot: %lu watchdog reset(s), session %s\n",
+           (unsigned long)recovery_status()->watchdog_resets,
+           recovery_status()->recovered ? "restored" : "lost");
+  }
+}
+#endif
 
 static void io_init(void) {
-  spi_init(SPI_PORT, SPI_SPEED_KHZ * 1000);
+  spi_init(SPI_PORT, g_settings.spi_speed_khz * 1000);
   gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
   gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
   gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
@@ -79,16 +136,78 @@ static void io_init(void) {
   gpio_set_dir(25, GPIO_OUT);
 }
 
+// Holding SELECT while plugging in selects generic HID gamepad (PC) mode
+// (short retry: this delays USB attach)
+#define USB_MODE_SELECT_RETRY 3
+
+static void select_usb_mode(void) {
+  uint8_t pad_id;
+  uint8_t psx_recv[22];
+  int retry;
+
+  for (retry = 0; retry < USB_MODE_SELECT_RETRY; retry++) {
+    if (get_psx_pad_data(psx_recv, &pad_id)) {
+      if (psx_recv[1] & PSX_BUTTON1_SELECT) {
+        g_usb_mode = USB_MODE_PC;
+      }
+      return;
+    }
+    sleep_ms(2);
+  }
+}
+
 /*------------- MAIN -------------*/
 int main() {
+  boot_phase(BOOT_PHASE_MAIN);
   board_init();
+  boot_phase(BOOT_PHASE_BOARD_INIT);
+  settings_init();
+  // After a watchdog reset: previous MAC / USB mode, no mode selection
+  recovery_init();
+#ifdef PSX_SNIFFER
+  // The console drives the bus: capture only, never touch SPI / CS
+  g_usb_mode = USB_MODE_SNIFFER;
+  psx_sniffer_init();
+#else
   io_init();
+  if (!recovery_status()->recovered) {
+#ifdef STICK_FILTER_BENCH
+    stick_filter_benchmark();
+#endif
+#ifdef KERNEL_BENCH
+    kernel_bench_target();
+#endif
+    select_usb_mode();
+  }
+#endif
+#ifdef INPUT_INJECT
+  input_inject_init();
+#endif
+  boot_phase(BOOT_PHASE_IO_INIT);
 
   tusb_init();
+  boot_phase(BOOT_PHASE_USB_INIT);
+
+  // From here on, a stalled main loop resets the device
+  recovery_arm();
 
   while (1) {
+    recovery_task();
+
     tud_task();  // tinyusb device task
+
     hid_task();
+
+    // Flash writes requested over the settings channel
+    settings_task();
+
+#ifdef INPUT_INJECT
+    // Frames streamed from the PC (UART1)
+    input_inject_task();
+#endif
+
+    // Stream trace records while the UART FIFO has room (never blocks)
+    trace_drain();
   }
 
   return 0;
@@ -99,18 +218,36 @@ int main() {
 //--------------------------------------------------------------------+
 
 // Invoked when device is mounted
-void tud_mount_cb(void) {}
+void tud_mount_cb(void) {
+  static bool mac_ready = false;
+
+  boot_phase(BOOT_PHASE_MOUNT);
+  // Before the first set_report (the 0x80 0x01 reply carries the MAC), once
+  // per power-up so it stays the same across re-mounts.
+  // Time of mount (in us) differs between power-ups: good enough MAC seed
+  // (restored session: keep the MAC the host knows)
+  if (!mac_ready) {
+    if (!recovery_status()->recovered) {
+      init_sw_module();
+    }
+    mac_ready = true;
+  }
+  sw_state_mount();
+}
 
 // Invoked when device is unmounted
-void tud_umount_cb(void) {}
+void tud_umount_cb(void) { sw_state_umount(); }
 
 // Invoked when usb bus is suspended
 // remote_wakeup_en : if host allow us  to perform remote wakeup
 // Within 7ms, device must draw an average of current less than 2.5 mA from bus
-void tud_suspend_cb(bool remote_wakeup_en) { (void)remote_wakeup_en; }
+void tud_suspend_cb(bool remote_wakeup_en) {
+  (void)remote_wakeup_en;
+  sw_state_suspend();
+}
 
 // Invoked when usb bus is resumed
-void tud_resume_cb(void) {}
+void tud_resume_cb(void) { sw_state_resume(); }
 
 //--------------------------------------------------------------------+
 // USB HID
@@ -122,6 +259,23 @@ void tud_resume_cb(void) {}
 uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id,
                                hid_report_type_t report_type, uint8_t *buf,
                                uint16_t reqlen) {
+  (void)itf;
+
+  // Settings / status channel is in the PC descriptor only: the Switch
+  // descriptor stays the same as a real Pro Controller's
+  if (g_usb_mode != USB_MODE_PC) return 0;
+
+  if (report_id == SETTINGS_REPORT_ID &&
+      report_type == HID_REPORT_TYPE_FEATURE && reqlen >= sizeof(g_settings)) {
+    memcpy(buf, &g_settings, sizeof(g_settings));
+    return sizeof(g_settings);
+  }
+  if (report_id == RECOVERY_STATUS_REPORT_ID &&
+      report_type == HID_REPORT_TYPE_FEATURE &&
+      reqlen >= sizeof(RECOVERY_STATUS_t)) {
+    memcpy(buf, recovery_status(), sizeof(RECOVERY_STATUS_t));
+    return sizeof(RECOVERY_STATUS_t);
+  }
   return 0;
 }
 
@@ -130,79 +284,46 @@ uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id,
 void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
                            hid_report_type_t report_type, uint8_t const *buf,
                            uint16_t bufsize) {
-  static bool sw_module_initialized = false;
-
-  if (!sw_module_initialized) {
-    init_sw_module();
+  if (g_usb_mode == USB_MODE_PC) {
+    // Settings channel: control request (report ID already stripped) or
+    // OUT endpoint (report ID in buf[0])
+    if (report_id == 0 && report_type == 0 && bufsize > 0) {
+      report_id = buf[0];
+      buf++;
+      bufsize--;
+    }
+    if (report_id == SETTINGS_REPORT_ID) {
+      settings_request(buf, bufsize);
+    } else if (report_id == SETTINGS_CMD_REPORT_ID && bufsize > 0) {
+      settings_command(buf[0]);
+    }
+    return;
   }
 
+  boot_phase(BOOT_PHASE_HANDSHAKE);
+
   if (report_id == 0 && report_type == 0) {
-    SW_REPORT_t report;
-    memset(&report, 0, sizeof(report));
-    handle_host_data(&report, buf, bufsize);
-    tud_hid_report(report.report_id, report.data, SW_REPORT_SIZE - 1);
+    // Reply queue full: held and handled by sw_tx_task() in order
+    sw_host_command(buf, bufsize);
   }
 }
 
 //--------------------------------------------------------------------+
 // HID TASK
 //--------------------------------------------------------------------+
-// PSX report: L D R U  St R3 L3 Se   [] X O ^   R1 L1 R2 L2
-//             --------------------   -----------------------
-//             report[1] Button1      report[2]  Button2
-
-#define IS_BUTTON(button_val, button_const) \
-  (((button_val) & (button_const)) / (button_const))
-
-static void make_button_report(uint8_t *psx_recv, uint8_t *sw_input) {
-  uint8_t psx_button1 = psx_recv[1];
-  uint8_t psx_button2 = psx_recv[2];
-
-  int joy_mode = gpio_get(PIN_MODE);
-
-  if (joy_mode == false) {
-    // Normal Pro-con mode
-    sw_input[0] =
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_A) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_CROSS) << SW_REP0_BITPOS_B) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_TRIANGLE) << SW_REP0_BITPOS_X) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_RECT) << SW_REP0_BITPOS_Y) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_R2) << SW_REP0_BITPOS_ZR) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_R);
-
-    sw_input[1] =
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_SELECT) << SW_REP1_BITPOS_HOME) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP1_BITPOS_PLUS) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_L3) << SW_REP1_BITPOS_THUMBL) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_R3) << SW_REP1_BITPOS_THUMBR);
-
-    sw_input[2] =
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_DOWN) << SW_REP2_BITPOS_DOWN) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_UP) << SW_REP2_BITPOS_UP) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_RIGHT) << SW_REP2_BITPOS_RIGHT) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_LEFT) << SW_REP2_BITPOS_LEFT) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_L1) << SW_REP2_BITPOS_L) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_L2) << SW_REP2_BITPOS_ZL);
-  } else {
-    // Tata-con mode
-    // Tata-con    ML      MR   TL     TR    ST   SEL
-    // PSX         LEFT    O    L1     R1    ST   SEL
-    // Switch      RIGHT   B    LEFT   A     DOWN HOME
-    sw_input[0] =
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_B) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_A);
-
-    sw_input[1] =
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_SELECT) << SW_REP1_BITPOS_HOME);
-
-    sw_input[2] =
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP2_BITPOS_DOWN) |
-        (IS_BUTTON(psx_button1, PSX_BUTTON1_LEFT) << SW_REP2_BITPOS_RIGHT) |
-        (IS_BUTTON(psx_button2, PSX_BUTTON2_L1) << SW_REP2_BITPOS_LEFT);
+
+// Snap sticks within `deadzone` counts of center to center
+static void __not_in_flash_func(apply_deadzone)(uint8_t *sticks,
+                                                uint8_t deadzone) {
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    int d = sticks[i] - 0x80;
+    if (d >= -deadzone && d <= deadzone) sticks[i] = 0x80;
   }
 }
 
-void input_response(void) {
+void __not_in_flash_func(input_response)(void) {
   uint8_t sw_report[SW_REPORT_SIZE];
 
   memcpy(sw_report, sw_initial_input_report, sizeof(sw_initial_input_report));
@@ -210,73 +331,186 @@ void input_response(void) {
   // Read PSX pad data
   uint8_t pad_id;
   uint8_t psx_recv[22];
-  uint8_t sw_input[9];
-  uint8_t report_length;
 
-  bool result = get_psx_pad_data(psx_recv, &pad_id);
+  bool result = get_psx_pad_input(psx_recv, &pad_id);
+  const PSX_DECODER_t *decoder = psx_find_decoder(pad_id);
+
+  // Filter history belongs to one device and mode
+  if (pad_id != filter_id) {
+    stick_filter_reset(&stick_filter);
+    filter_id = pad_id;
+  }
+  pad_has_sticks = decoder->flags & PSX_DECODER_STICKS;
+  if (decoder->flags & PSX_DECODER_STICKS) {
+    // Replace raw stick values with filtered ones
+    if (g_settings.stick_filter) {
+      if (result) {
+        stick_filter_update(&stick_filter, psx_recv + 3);
+      }
+      stick_filter_get(&stick_filter, psx_recv + 3);
+    }
+    apply_deadzone(psx_recv + 3, g_settings.stick_deadzone);
+  }
 
   // Build HID report according to the controller type
-  uint8_t dir;
-
-  // extract stick/button info
-  dir = (psx_recv[1] & 0xf0) >> 4;  // L D R U
-
-  switch (pad_id) {
-    case PSX_CTRLID_DIGITAL:
-      // build HID report for digital mode
-      make_button_report(psx_recv, sw_input);
-      memset(sw_input + 3, 0, 6);
-      report_length = 3;
-      break;
-
-    case PSX_CTRLID_DUAL_ANALOG:
-      // build HID report for analog mode
-      make_button_report(psx_recv, sw_input);
-      report_length = 9;
-
-      // psx 3: X2
-      // psx 4: Y2
-      // psx 5: X1
-      // psx 6: Y1
-
-      // Left X  - PSX Left X
-      sw_input[3] = (psx_recv[5] << 4) & 0xff;
-      sw_input[4] = psx_recv[5] >> 4;  // Upper 4bits are zero (Y lower)
-
-      // Left Y  - PSX Left Y
-      sw_input[5] = ~psx_recv[6];
-
-      // Right X  - PSX Right X
-      sw_input[6] = (psx_recv[3] << 4) & 0xff;
-      sw_input[7] = psx_recv[3] >> 4;
-
-      // Right Y  - PSX Right Y
-      sw_input[8] = ~psx_recv[4];
-      break;
-
-    default:
-      break;
+  // .. skipping connection_info | bettery_level
+  decoder->map(psx_recv, sw_report + 1);
+
+  // Right stick may drive the synthesized gyro instead
+  imu_synth_report(psx_recv, decoder->flags & PSX_DECODER_STICKS,
+                   sw_report + 1);
+
+#ifdef INPUT_INJECT
+  // PC-streamed frame replaces the pad, a pad in use wins
+  input_inject_apply(sw_report + 1,
+                     pad_id != PSX_CTRLID_INVALID &&
+                         input_inject_pad_active(
+                             psx_recv, decoder->flags & PSX_DECODER_STICKS,
+                             g_settings.stick_deadzone));
+#endif
+
+  // Report itself is built and sent by sw_tx_task()
+  sw_update_input(sw_report);
+  sw_queue_input();
+
+#ifdef BOOT_TIMING
+  if (boot_time_us[BOOT_PHASE_FIRST_INPUT] == 0) {
+    boot_phase(BOOT_PHASE_FIRST_INPUT);
+    print_boot_timing();
+  }
+#else
+  boot_phase(BOOT_PHASE_FIRST_INPUT);
+#endif
+}
+
+#ifdef HOT_PATH_TIMING
+// poll/map/report duration statistics, printed every 1000 reports
+// (compare ps_switch and ps_switch_ram: max - min is the jitter)
+#define HOT_PATH_TIMING_REPORTS 1000
+
+static void hot_path_timing_record(uint32_t elapsed_us) {
+  static uint32_t min_us = UINT32_MAX;
+  static uint32_t max_us = 0;
+  static uint32_t total_us = 0;
+  static uint32_t count = 0;
+
+  if (elapsed_us < min_us) min_us = elapsed_us;
+  if (elapsed_us > max_us) max_us = elapsed_us;
+  total_us += elapsed_us;
+
+  if (++count == HOT_PATH_TIMING_REPORTS) {
+    printf("hot path: min %lu us, avg %lu us, max %lu us, jitter %lu us\n",
+           (unsigned long)min_us, (unsigned long)(total_us / count),
+           (unsigned long)max_us, (unsigned long)(max_us - min_us));
+    min_us = UINT32_MAX;
+    max_us = 0;
+    total_us = 0;
+    count = 0;
+  }
+}
+#endif
+
+// Sample sticks between reports and feed them into the filter
+static void stick_oversample_task(void) {
+  static uint32_t last_us = 0;
+
+  if (!pad_has_sticks) return;
+  if (time_us_32() - last_us < STICK_OVERSAMPLE_INTERVAL_US) return;
+  last_us = time_us_32();
+
+  uint8_t pad_id;
+  uint8_t psx_recv[22];
+
+  if (get_psx_pad_data(psx_recv, &pad_id) &&
+      (psx_find_decoder(pad_id)->flags & PSX_DECODER_STICKS)) {
+    stick_filter_update(&stick_filter, psx_recv + 3);
+    imu_synth_pad(psx_recv);
+  }
+}
+
+// PC mode: sample the pad right before queuing each report.
+// tud_hid_ready() becomes true once the host has taken the previous report,
+// so the pad sample is at most one USB frame old.
+static void pc_hid_task(void) {
+  static bool pressure_tried = false;
+
+  if (!tud_hid_ready()) return;
+
+  uint8_t pad_id;
+  uint8_t psx_recv[22];
+  PC_REPORT_t report;
+
+  get_psx_pad_input(psx_recv, &pad_id);
+
+  // DualShock2: enable pressure once per plug-in
+  if (pad_id == PSX_CTRLID_INVALID) {
+    pressure_tried = false;
+  } else if (pad_id == PSX_CTRLID_DUAL_ANALOG && !pressure_tried) {
+    pressure_tried = true;
+    psx_enable_pressure();
+  }
+
+  if (psx_find_decoder(pad_id)->flags & PSX_DECODER_STICKS) {
+    apply_deadzone(psx_recv + 3, g_settings.stick_deadzone);
+  }
+  build_pc_report(&report, psx_recv, pad_id);
+  if (tud_hid_report(PC_REPORT_ID, &report, sizeof(report))) {
+    TRACE(TRACE_EV_REPORT_SENT, 0, 0);
   }
-  // Copy input data into report .. skipping connection_info | bettery_level
-  memcpy(sw_report + 1, sw_input, report_length);
-
-  SW_REPORT_t report;
-  memset(&report, 0, sizeof(report));
-  build_sw_report(&report, 0x30, (board_millis() / 10) % 256, sw_report,
-                  sizeof(sw_initial_input_report));
-  tud_hid_report(report.report_id, report.data, SW_REPORT_SIZE - 1);
 }
 
 void hid_task(void) {
-  const uint32_t interval_ms = SW_REPORT_INTERVAL_MS;
+  // New settings take effect between two reports
+  settings_apply_pending();
+
+  const uint32_t interval_ms = g_settings.report_interval_ms;
+
+  if (g_usb_mode == USB_MODE_PC) {
+    pc_hid_task();
+    return;
+  }
+#ifdef PSX_SNIFFER
+  if (g_usb_mode == USB_MODE_SNIFFER) {
+    psx_sniffer_task();
+    return;
+  }
+#endif
   static uint32_t start_ms = 0;
+  static bool input_enabled = false;
 
-  if (board_millis() - start_ms < interval_ms) return;  // not enough time
-  start_ms += interval_ms;
+  // Pending replies go out as soon as the endpoint is free
+  sw_tx_task();
 
-  if (!tud_hid_ready()) return;
+  sw_state_task();
+
+  // Send the first input right away instead of waiting for the next tick
+  if (g_input_enable != input_enabled) {
+    input_enabled = g_input_enable;
+    if (input_enabled) {
+      boot_phase(BOOT_PHASE_INPUT_ENABLE);
+      start_ms = board_millis() - interval_ms;
+    }
+  }
+
+  if (board_millis() - start_ms < interval_ms) {
+    // Keep probing the pad during enumeration / handshake too, so the pad
+    // type and stick filter are settled by the first input report
+    stick_oversample_task();
+    // Motion samples are taken here, never while building a report
+    imu_synth_task();
+    return;  // not enough time
+  }
+  start_ms += interval_ms;
 
   if (g_input_enable) {
+#ifdef HOT_PATH_TIMING
+    uint32_t t0 = time_us_32();
+    input_response();
+    sw_tx_task();
+    hot_path_timing_record(time_us_32() - t0);
+#else
     input_response();
+    sw_tx_task();
+#endif
   }
 }
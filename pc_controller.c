@@ -0,0 +1,67 @@
+/*
+    Generic HID gamepad (PC host) report builder
+*/
+
+#include "pc_controller.h"
+
+#include <string.h>
+
+#include "psx_controller.h"
+
+// PSX direction bits (L D R U) -> HID hat switch
+// 0: N, 1: NE, 2: E, 3: SE, 4: S, 5: SW, 6: W, 7: NW, 8: center
+static const uint8_t hat_table[16] = {
+    // L D R U
+    PC_HAT_CENTER,  // 0000
+    0,              // 0001 U
+    2,              // 0010 R
+    1,              // 0011 R U
+    4,              // 0100 D
+    PC_HAT_CENTER,  // 0101 D U
+    3,              // 0110 D R
+    2,              // 0111 D R U
+    6,              // 1000 L
+    7,              // 1001 L U
+    PC_HAT_CENTER,  // 1010 L R
+    0,              // 1011 L R U
+    5,              // 1100 L D
+    6,              // 1101 L D U
+    4,              // 1110 L D R
+    PC_HAT_CENTER,  // 1111
+};
+
+void build_pc_report(PC_REPORT_t *report, const uint8_t *psx_recv,
+                     uint8_t pad_id) {
+  memset(report, 0, sizeof(PC_REPORT_t));
+  report->lx = report->ly = report->rx = report->ry = 0x80;
+
+  if (pad_id == PSX_CTRLID_INVALID) {
+    report->buttons = PC_HAT_CENTER << 12;
+    return;
+  }
+
+  uint8_t psx_button1 = psx_recv[1];
+  uint8_t psx_button2 = psx_recv[2];
+
+  // Button 1-8:  [] X O ^ R1 L1 R2 L2 -> reversed order of PSX Button2
+  // Button 9-12: Select L3 R3 Start
+  uint16_t buttons = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    buttons |= ((psx_button2 >> (7 - i)) & 1) << i;
+  }
+  buttons |= (psx_button1 & 0x0f) << 8;
+  buttons |= hat_table[psx_button1 >> 4] << 12;
+  report->buttons = buttons;
+
+  if (pad_id == PSX_CTRLID_DUAL_ANALOG || pad_id == PSX_CTRLID_DUAL_SHOCK2) {
+    report->rx = psx_recv[3];
+    report->ry = psx_recv[4];
+    report->lx = psx_recv[5];
+    report->ly = psx_recv[6];
+  }
+
+  if (pad_id == PSX_CTRLID_DUAL_SHOCK2) {
+    memcpy(report->pressure, psx_recv + 7, PSX_PRESSURE_COUNT);
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// USB personality (selected once at boot)
+#define USB_MODE_SWITCH 0  // Nintendo Pro Controller emulation
+#define USB_MODE_PC 1      // Generic HID gamepad for PC hosts
+#define USB_MODE_SNIFFER 2  // Passive PSX bus capture (PSX_SNIFFER build)
+
+// PC gamepad report is sent every USB frame (bInterval = 1)
+#define PC_REPORT_INTERVAL_MS 1
+
+// Gamepad input report ID (the descriptor also carries the settings reports)
+#define PC_REPORT_ID 0x01
+
+// Hat switch value for "no direction"
+#define PC_HAT_CENTER 0x08
+
+// DS2 pressure bytes (psx_recv[7..18])
+#define PSX_PRESSURE_COUNT 12
+
+// Buttons 1-12, hat switch 4bits, 4 sticks, 12 pressure values
+typedef struct __attribute__((packed)) {
+  uint16_t buttons;  // bit0-11: buttons, bit12-15: hat switch
+  uint8_t lx;
+  uint8_t ly;
+  uint8_t rx;
+  uint8_t ry;
+  uint8_t pressure[PSX_PRESSURE_COUNT];
+} PC_REPORT_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void build_pc_report(PC_REPORT_t *report, const uint8_t *psx_recv,
+                     uint8_t pad_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+extern uint8_t g_usb_mode;
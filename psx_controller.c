@@ -1,15 +1,21 @@
 #include "psx_controller.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "bsp/board.h"
 #include "hardware/spi.h"
 #include "pico/stdlib.h"
+#include "psx_decoder.h"
+#include "trace_log.h"
 
 // Command sequence
 
 #define PSX_CTRLER_ADDR 0x01
 #define PSX_COMM_POLL 0x42
+#define PSX_COMM_CONFIG 0x43
+#define PSX_COMM_SET_ANALOG 0x44
+#define PSX_COMM_SET_PRESSURE 0x4f
 
 static inline uint8_t bit_reverse(uint8_t data) {
   uint16_t tmp;
@@ -23,7 +29,7 @@ static inline uint8_t bit_reverse(uint8_t data) {
   return (uint8_t)(tmp & 0xff);
 }
 
-static void bit_reverse_array(uint8_t *data, int len) {
+void __not_in_flash_func(bit_reverse_array)(uint8_t *data, int len) {
   int index;
 
   for (index = 0; index < len; index++) {
@@ -33,7 +39,7 @@ static void bit_reverse_array(uint8_t *data, int len) {
 
 #define ACK_TIMEOUT_US 100
 
-static bool wait_psx_pad_ack() {
+static bool __not_in_flash_func(wait_psx_pad_ack)() {
   absolute_time_t timeout;
 
   timeout = make_timeout_time_us(ACK_TIMEOUT_US);
@@ -48,8 +54,8 @@ static bool wait_psx_pad_ack() {
   }
 }
 
-bool comm_psx_pad(uint8_t *send, uint8_t *recv, uint8_t len,
-                  bool skip_last_byte_ack) {
+bool __not_in_flash_func(comm_psx_pad)(uint8_t *send, uint8_t *recv,
+                                       uint8_t len, bool skip_last_byte_ack) {
   int index;
 
   bit_reverse_array(send, 2);
@@ -59,6 +65,7 @@ bool comm_psx_pad(uint8_t *send, uint8_t *recv, uint8_t len,
     if ((skip_last_byte_ack == false ||
          (skip_last_byte_ack == true && index != (len - 1))) &&
         wait_psx_pad_ack() == false) {
+      TRACE(TRACE_EV_PSX_ACK_TIMEOUT, index, 0);
       return false;
     }
   }
@@ -68,11 +75,32 @@ bool comm_psx_pad(uint8_t *send, uint8_t *recv, uint8_t len,
   return true;
 }
 
-bool get_psx_pad_data(uint8_t *psx_report, uint8_t *pad_id) {
+// There is no checksum on the bus: a new controller ID is only accepted
+// after two polls in a row (a bit error in the ID byte can turn one valid
+// ID into another, e.g. 0x73 -> 0x53)
+static uint8_t confirmed_id = PSX_CTRLID_INVALID;
+static uint8_t candidate_id = PSX_CTRLID_INVALID;
+
+static bool __not_in_flash_func(confirm_id)(uint8_t id) {
+  if (id == confirmed_id) {
+    candidate_id = PSX_CTRLID_INVALID;
+    return true;
+  }
+  if (id == candidate_id) {
+    confirmed_id = id;  // mode change (e.g. ANALOG button) or new pad
+    return true;
+  }
+  candidate_id = id;
+  return false;
+}
+
+bool __not_in_flash_func(get_psx_pad_data)(uint8_t *psx_report,
+                                           uint8_t *pad_id) {
   uint8_t id;
   uint8_t psx_send[22];
 
   // Reading PSX pad state
+  TRACE(TRACE_EV_PSX_POLL_START, 0, 0);
 
   // Read Controller Type
   gpio_put(PIN_CS, 0);
@@ -91,27 +119,101 @@ bool get_psx_pad_data(uint8_t *psx_report, uint8_t *pad_id) {
   *pad_id = id;
 
   // Read state according to the controller type
-  switch (id) {
-    case PSX_CTRLID_DIGITAL:
-      result = comm_psx_pad(psx_send, psx_report, 3, true);
-      // invert bits for button part
-      psx_report[1] = ~psx_report[1];
-      psx_report[2] = ~psx_report[2];
-      break;
+  const PSX_DECODER_t *decoder = psx_find_decoder(id);
 
-    case PSX_CTRLID_DUAL_ANALOG:
-      result = comm_psx_pad(psx_send, psx_report, 7, true);
-      // invert bits for button part
-      psx_report[1] = ~psx_report[1];
-      psx_report[2] = ~psx_report[2];
-      break;
+  if (decoder->length > 0) {
+    result = comm_psx_pad(psx_send, psx_report, decoder->length, true);
+    // invert bits for button part
+    psx_report[1] = ~psx_report[1];
+    psx_report[2] = ~psx_report[2];
+  } else {
+    result = false;
+  }
+  // Un-select controller
+  gpio_put(PIN_CS, 1);
+
+  // Corrupted header: a failed poll, never another device
+  if (result && (psx_report[0] != PSX_DATA_START || !confirm_id(id))) {
+    result = false;
+    id = PSX_CTRLID_INVALID;
+    *pad_id = id;
+  }
+
+  TRACE(TRACE_EV_PSX_POLL_END, id, result);
+
+  return result;
+}
+
+// A bit error or the first poll after an ANALOG change must not release
+// every button for one report: repeat the last good poll instead
+bool __not_in_flash_func(get_psx_pad_input)(uint8_t *psx_report,
+                                            uint8_t *pad_id) {
+  static uint8_t last_report[22];
+  static uint8_t last_id = PSX_CTRLID_INVALID;
+  static uint8_t misses = 0;
+
+  if (get_psx_pad_data(psx_report, pad_id)) {
+    memcpy(last_report, psx_report, sizeof(last_report));
+    last_id = *pad_id;
+    misses = 0;
+    return true;
+  }
+  if (last_id != PSX_CTRLID_INVALID && ++misses > PSX_HOLD_POLLS) {
+    last_id = PSX_CTRLID_INVALID;  // pad is gone
+  }
+  if (last_id != PSX_CTRLID_INVALID) {
+    memcpy(psx_report, last_report, sizeof(last_report));
+  }
+  *pad_id = last_id;
+  return false;
+}
+
+// Send one command packet (whole packet is bit-reversed, unlike polling)
+static bool send_psx_command(const uint8_t *cmd, uint8_t len) {
+  uint8_t send[9];
+  uint8_t recv[9];
 
-    default:
+  memcpy(send, cmd, len);
+  bit_reverse_array(send, len);
+
+  gpio_put(PIN_CS, 0);
+  sleep_us(5);
+
+  bool result = true;
+  int index;
+  for (index = 0; index < len; index++) {
+    spi_write_read_blocking(SPI_PORT, &send[index], &recv[index], 1);
+    if (index != (len - 1) && wait_psx_pad_ack() == false) {
       result = false;
       break;
+    }
   }
-  // Un-select controller
+
   gpio_put(PIN_CS, 1);
+  sleep_us(20);
 
   return result;
 }
+
+bool psx_enable_pressure(void) {
+  static const uint8_t enter_config[] = {
+      PSX_CTRLER_ADDR, PSX_COMM_CONFIG, 0x00, 0x01, 0x00};
+  static const uint8_t set_analog[] = {
+      PSX_CTRLER_ADDR, PSX_COMM_SET_ANALOG, 0x00, 0x01, 0x03,
+      0x00,            0x00,                0x00, 0x00};
+  static const uint8_t set_pressure[] = {
+      PSX_CTRLER_ADDR, PSX_COMM_SET_PRESSURE, 0x00, 0xff, 0xff,
+      0x03,            0x00,                  0x00, 0x00};
+  static const uint8_t exit_config[] = {
+      PSX_CTRLER_ADDR, PSX_COMM_CONFIG, 0x00, 0x00, 0x5a,
+      0x5a,            0x5a,            0x5a, 0x5a};
+
+  if (!send_psx_command(enter_config, sizeof(enter_config))) {
+    return false;
+  }
+  // DualShock (PS1) does not support pressure command; exit config anyway
+  send_psx_command(set_analog, sizeof(set_analog));
+  send_psx_command(set_pressure, sizeof(set_pressure));
+
+  return send_psx_command(exit_config, sizeof(exit_config));
+}
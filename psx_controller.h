@@ -15,6 +15,8 @@ extern "C" {
 #define PIN_MODE 6
 
 #define SPI_PORT spi0
+// Default PSX SPI communication speed (see settings.h)
+#define SPI_SPEED_KHZ 250
 #define READ_BIT 0x80
 
 // Controller ID
@@ -24,6 +26,16 @@ extern "C" {
 #define PSX_CTRLID_ANALOG 0x53
 #define PSX_CTRLID_DUAL_ANALOG 0x73
 #define PSX_CTRLID_DUAL_SHOCK2 0x79
+#define PSX_CTRLID_MOUSE 0x12
+#define PSX_CTRLID_NEGCON 0x23
+#define PSX_CTRLID_GUNCON 0x63
+#define PSX_CTRLID_JOGCON 0xe3
+
+// 2nd reply byte of every poll (psx_report[0] after get_psx_pad_data())
+#define PSX_DATA_START 0x5a
+
+// Failed polls in a row that still repeat the last good input
+#define PSX_HOLD_POLLS 3
 
 // PSX Button
 
@@ -50,11 +62,18 @@ extern "C" {
 #define PSX_BUTTON2_R2 0x02
 #define PSX_BUTTON2_L2 0x01
 
+// PSX bus is LSB first, SPI is MSB first
+void bit_reverse_array(uint8_t *data, int len);
 // Raw communication
 bool comm_psx_pad(uint8_t *send, uint8_t *recv, uint8_t len,
                   bool skip_last_byte_ack);
 //
 bool get_psx_pad_data(uint8_t *psx_report, uint8_t *pad_id);
+// get_psx_pad_data() for the report: a failed poll repeats the last good one
+// (pad_id INVALID after PSX_HOLD_POLLS failures), true = fresh poll
+bool get_psx_pad_input(uint8_t *psx_report, uint8_t *pad_id);
+// Switch DualShock2 into analog + pressure mode (ID 0x79)
+bool psx_enable_pressure(void);
 
 #ifdef __cplusplus
 }
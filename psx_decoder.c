@@ -0,0 +1,265 @@
+/*
+    PSX device decoders
+
+    Each decoder maps the received PSX data into the Switch input part
+    (buttons + sticks).
+*/
+
+#include "psx_decoder.h"
+
+#include <string.h>
+
+#include "button_layout.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "settings.h"
+#include "sw_controller.h"
+
+// PSX report: L D R U  St R3 L3 Se   [] X O ^   R1 L1 R2 L2
+//             --------------------   -----------------------
+//             report[1] Button1      report[2]  Button2
+
+#define IS_BUTTON(button_val, button_const) \
+  (((button_val) & (button_const)) / (button_const))
+
+// Switch stick: 12bit X, 12bit Y packed into 3 bytes
+#define SW_STICK_CENTER 0x7f0
+#define SW_STICK_MAX 0xfff
+
+static inline void pack_stick(uint8_t *out, uint16_t x, uint16_t y) {
+  out[0] = x & 0xff;
+  out[1] = (x >> 8) | ((y & 0x0f) << 4);
+  out[2] = y >> 4;
+}
+
+static inline uint16_t clamp_stick(int32_t value) {
+  if (value < 0) return 0;
+  if (value > SW_STICK_MAX) return SW_STICK_MAX;
+  return value;
+}
+
+//--------------------------------------------------------------------+
+// Layouts (button_layout.h)
+//--------------------------------------------------------------------+
+// Each table row expands to one constant shift of the 16 PSX button bits
+// into the 24 Switch button bits; the compiler folds the whole table.
+
+#define BUTTON_ROW(psx_byte, psx_button, sw_byte, sw_bit)                  \
+  | (((buttons >> (((psx_byte) - 1) * 8 + __builtin_ctz(psx_button))) & 1) \
+     << ((sw_byte) * 8 + (sw_bit)))
+
+#define DEFINE_BUTTON_LAYOUT(name, TABLE)                                 \
+  static __force_inline void name(const uint8_t *psx_recv,               \
+                                  uint8_t *sw_input) {                   \
+    uint32_t buttons = psx_recv[1] | (psx_recv[2] << 8);                  \
+    uint32_t out = 0 TABLE(BUTTON_ROW);                                   \
+    sw_input[0] = out;                                                    \
+    sw_input[1] = out >> 8;                                               \
+    sw_input[2] = out >> 16;                                              \
+  }
+
+#define STICK_ROW(sw_offset, x_byte, x_xor, y_byte, y_xor)                \
+  pack_stick(sw_input + (sw_offset), (psx_recv[x_byte] ^ (x_xor)) << 4,  \
+             (psx_recv[y_byte] ^ (y_xor)) << 4);
+
+DEFINE_BUTTON_LAYOUT(layout_procon_buttons, LAYOUT_PROCON_BUTTONS)
+DEFINE_BUTTON_LAYOUT(layout_taiko_buttons, LAYOUT_TAIKO_BUTTONS)
+
+static __force_inline void make_stick_report(const uint8_t *psx_recv,
+                                             uint8_t *sw_input) {
+  LAYOUT_STICKS(STICK_ROW)
+}
+
+static void __not_in_flash_func(make_button_report)(const uint8_t *psx_recv,
+                                                    uint8_t *sw_input) {
+#if defined(BUTTON_LAYOUT_PROCON)
+  layout_procon_buttons(psx_recv, sw_input);
+#elif defined(BUTTON_LAYOUT_TAIKO)
+  layout_taiko_buttons(psx_recv, sw_input);
+#else
+  int joy_mode;
+
+  switch (g_settings.button_layout) {
+    case SETTINGS_LAYOUT_PROCON:
+      joy_mode = false;
+      break;
+    case SETTINGS_LAYOUT_TAIKO:
+      joy_mode = true;
+      break;
+    default:
+      joy_mode = gpio_get(PIN_MODE);
+      break;
+  }
+
+  if (joy_mode == false) {
+    layout_procon_buttons(psx_recv, sw_input);
+  } else {
+    layout_taiko_buttons(psx_recv, sw_input);
+  }
+#endif
+}
+
+//--------------------------------------------------------------------+
+// Decoders
+//--------------------------------------------------------------------+
+
+static void map_none(const uint8_t *psx_recv, uint8_t *sw_input) {
+  (void)psx_recv;
+  memset(sw_input, 0, 3);
+  pack_stick(sw_input + 3, SW_STICK_CENTER, SW_STICK_CENTER);
+  pack_stick(sw_input + 6, SW_STICK_CENTER, SW_STICK_CENTER);
+}
+
+// Digital pad: 5A B1 B2
+static void __not_in_flash_func(map_digital)(const uint8_t *psx_recv,
+                                             uint8_t *sw_input) {
+  make_button_report(psx_recv, sw_input);
+  pack_stick(sw_input + 3, SW_STICK_CENTER, SW_STICK_CENTER);
+  pack_stick(sw_input + 6, SW_STICK_CENTER, SW_STICK_CENTER);
+}
+
+// Analog pad: 5A B1 B2 RX RY LX LY (DS2 pressure bytes follow, unused)
+static void __not_in_flash_func(map_analog)(const uint8_t *psx_recv,
+                                            uint8_t *sw_input) {
+  make_button_report(psx_recv, sw_input);
+  make_stick_report(psx_recv, sw_input);
+}
+
+// NeGcon: 5A B1 B2 TWIST I II L
+// B1: St U R D L, B2: R1(R) ^(B) O(A)
+// Twist -> left stick X, I -> ZR, II -> B, L -> ZL (analog over threshold)
+#define NEGCON_ANALOG_THRESHOLD 0x40
+
+static void map_negcon(const uint8_t *psx_recv, uint8_t *sw_input) {
+  uint8_t psx_button1 = psx_recv[1];
+  uint8_t psx_button2 = psx_recv[2];
+
+  sw_input[0] =
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_A) |
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_TRIANGLE) << SW_REP0_BITPOS_Y) |
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_R) |
+      ((psx_recv[4] >= NEGCON_ANALOG_THRESHOLD) << SW_REP0_BITPOS_ZR) |
+      ((psx_recv[5] >= NEGCON_ANALOG_THRESHOLD) << SW_REP0_BITPOS_B);
+
+  sw_input[1] =
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP1_BITPOS_PLUS);
+
+  sw_input[2] =
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_DOWN) << SW_REP2_BITPOS_DOWN) |
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_UP) << SW_REP2_BITPOS_UP) |
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_RIGHT) << SW_REP2_BITPOS_RIGHT) |
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_LEFT) << SW_REP2_BITPOS_LEFT) |
+      ((psx_recv[6] >= NEGCON_ANALOG_THRESHOLD) << SW_REP2_BITPOS_ZL);
+
+  pack_stick(sw_input + 3, psx_recv[3] << 4, SW_STICK_CENTER);
+  pack_stick(sw_input + 6, SW_STICK_CENTER, SW_STICK_CENTER);
+}
+
+// GunCon: 5A B1 B2 XL XH YL YH
+// B1: St(A), B2: O(trigger) X(B)
+// Screen position -> right stick (absolute), off-screen -> center
+#define GUNCON_X_MIN 77
+#define GUNCON_X_MAX 461
+#define GUNCON_Y_MIN 25
+#define GUNCON_Y_MAX 248
+
+static void map_guncon(const uint8_t *psx_recv, uint8_t *sw_input) {
+  uint8_t psx_button1 = psx_recv[1];
+  uint8_t psx_button2 = psx_recv[2];
+  int32_t x = psx_recv[3] | (psx_recv[4] << 8);
+  int32_t y = psx_recv[5] | (psx_recv[6] << 8);
+
+  sw_input[0] =
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_ZR) |
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_CROSS) << SW_REP0_BITPOS_B) |
+      (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP0_BITPOS_A);
+  sw_input[1] = 0;
+  sw_input[2] = 0;
+
+  pack_stick(sw_input + 3, SW_STICK_CENTER, SW_STICK_CENTER);
+  if (x < GUNCON_X_MIN || y < GUNCON_Y_MIN) {
+    // Off-screen (X=1, Y=10)
+    pack_stick(sw_input + 6, SW_STICK_CENTER, SW_STICK_CENTER);
+  } else {
+    x = (x - GUNCON_X_MIN) * SW_STICK_MAX / (GUNCON_X_MAX - GUNCON_X_MIN);
+    y = (GUNCON_Y_MAX - y) * SW_STICK_MAX / (GUNCON_Y_MAX - GUNCON_Y_MIN);
+    pack_stick(sw_input + 6, clamp_stick(x), clamp_stick(y));
+  }
+}
+
+// PS Mouse: 5A FF B2 DX DY
+// B2: R1(left) L1(right)
+// Deltas -> right stick (camera)
+#define MOUSE_GAIN 32
+
+static void map_mouse(const uint8_t *psx_recv, uint8_t *sw_input) {
+  uint8_t psx_button2 = psx_recv[2];
+  int32_t dx = (int8_t)psx_recv[3];
+  int32_t dy = (int8_t)psx_recv[4];
+
+  sw_input[0] =
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_ZR);
+  sw_input[1] = 0;
+  sw_input[2] =
+      (IS_BUTTON(psx_button2, PSX_BUTTON2_L1) << SW_REP2_BITPOS_ZL);
+
+  pack_stick(sw_input + 3, SW_STICK_CENTER, SW_STICK_CENTER);
+  pack_stick(sw_input + 6, clamp_stick(SW_STICK_CENTER + dx * MOUSE_GAIN),
+             clamp_stick(SW_STICK_CENTER - dy * MOUSE_GAIN));
+}
+
+// Jogcon (jog mode): 5A B1 B2 POSL POSH STAT 00
+// Reported as 0xe3 once the dial is switched to analog (jog) mode.
+// Buttons as digital pad, dial rotation per report -> left stick X
+#define JOGCON_GAIN 64
+
+static void map_jogcon(const uint8_t *psx_recv, uint8_t *sw_input) {
+  static int16_t last_pos = 0;
+  int16_t pos = psx_recv[3] | (psx_recv[4] << 8);
+  int32_t delta = (int16_t)(pos - last_pos);
+  last_pos = pos;
+
+  make_button_report(psx_recv, sw_input);
+  pack_stick(sw_input + 3, clamp_stick(SW_STICK_CENTER + delta * JOGCON_GAIN),
+             SW_STICK_CENTER);
+  pack_stick(sw_input + 6, SW_STICK_CENTER, SW_STICK_CENTER);
+}
+
+//--------------------------------------------------------------------+
+// Decoder table
+//--------------------------------------------------------------------+
+
+// Looked up for every report: table and lookup live in SRAM
+static const PSX_DECODER_t __not_in_flash("psx_decoders") psx_decoders[] = {
+    {PSX_CTRLID_DIGITAL, 3, 0, map_digital},
+    {PSX_CTRLID_ANALOG, 7, PSX_DECODER_STICKS, map_analog},
+    {PSX_CTRLID_DUAL_ANALOG, 7, PSX_DECODER_STICKS, map_analog},
+    {PSX_CTRLID_DUAL_SHOCK2, 19, PSX_DECODER_STICKS, map_analog},
+    {PSX_CTRLID_NEGCON, 7, 0, map_negcon},
+    {PSX_CTRLID_GUNCON, 7, 0, map_guncon},
+    {PSX_CTRLID_MOUSE, 5, 0, map_mouse},
+    {PSX_CTRLID_JOGCON, 7, 0, map_jogcon},
+};
+
+static const PSX_DECODER_t __not_in_flash("psx_decoders")
+    psx_decoder_none = {PSX_CTRLID_INVALID, 0, 0, map_none};
+
+const PSX_DECODER_t *__not_in_flash_func(psx_find_decoder)(uint8_t pad_id) {
+  static const PSX_DECODER_t *last = &psx_decoder_none;
+  size_t i;
+
+  // Same device as last time: no table lookup
+  if (last->pad_id == pad_id) {
+    return last;
+  }
+
+  last = &psx_decoder_none;
+  for (i = 0; i < sizeof(psx_decoders) / sizeof(psx_decoders[0]); i++) {
+    if (psx_decoders[i].pad_id == pad_id) {
+      last = &psx_decoders[i];
+      break;
+    }
+  }
+
+  return last;
+}
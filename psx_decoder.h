@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Switch input part built by decoders:
+// buttons(3) + left stick(3) + right stick(3)
+#define SW_INPUT_SIZE 9
+
+// Decoder flags
+#define PSX_DECODER_STICKS 0x01  // psx_recv[3..6] are RX RY LX LY sticks
+
+// PSX device decoder
+// Selected once per detected controller ID; the report path makes a single
+// indirect call to map().
+typedef struct {
+  uint8_t pad_id;
+  uint8_t length;  // bytes to read after the ID byte (including 0x5A)
+  uint8_t flags;
+  void (*map)(const uint8_t *psx_recv, uint8_t *sw_input);
+} PSX_DECODER_t;
+
+// Never returns NULL (unknown IDs get a decoder reporting nothing)
+const PSX_DECODER_t *psx_find_decoder(uint8_t pad_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,355 @@
+/*
+    Passive PSX bus sniffer (PSX_SNIFFER build)
+
+    PIO samples MOSI/MISO on each SCK rising edge while CS is low and pushes
+    one word per byte (+ one marker word per frame) to a DMA ring.
+    CS/ACK edges are timestamped in a GPIO interrupt, which also records how
+    far the DMA has written at CS release. The main loop pairs each marker
+    with the timing record taken right after it was written, so a CS pulse
+    seen by only one side costs one frame and never shifts the pairing.
+*/
+
+#include "psx_sniffer.h"
+
+#include <string.h>
+
+#ifdef PSX_SNIFFER
+
+#include "bsp/board.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "tusb.h"
+
+// `in pins` reads SCK, MOSI, MISO from one base pin
+#if (PIN_MOSI != PIN_SCK + 1) || (PIN_MISO != PIN_SCK + 2)
+#error "sniffer needs SCK, MOSI, MISO on consecutive pins"
+#endif
+
+#define SNIFFER_PIO pio0
+
+// DMA write ring: 2^13 bytes = 2048 words (bytes on the bus)
+#define SNIFFER_RING_BITS 13
+#define SNIFFER_RING_WORDS ((1 << SNIFFER_RING_BITS) / 4)
+#define SNIFFER_DMA_COUNT 0xffffffff
+
+// Frame timing records (CS interrupt -> main loop), must be power of 2
+#define SNIFFER_TIMING_SIZE 32
+
+// PIO marks the end of each frame with its 15-bit frame number:
+// bits 31-17 = -frame number, bits 16-0 = 1 (data words have bits 15-0 = 0)
+#define SNIFFER_SEQ_MASK 0x7fff
+#define SNIFFER_MARKER_MASK 0xffff
+
+typedef struct {
+  uint32_t start_us;
+  uint32_t end_word;  // ring words written at CS release
+  uint16_t duration_us;
+  uint8_t ack_count;
+  uint8_t flags;
+} FRAME_TIMING_t;
+
+static uint32_t ring[SNIFFER_RING_WORDS]
+    __attribute__((aligned(1 << SNIFFER_RING_BITS)));
+static uint dma_chan;
+static volatile uint32_t dma_base = 0;  // words written before the last re-arm
+static uint32_t read_count = 0;
+
+static FRAME_TIMING_t timing_ring[SNIFFER_TIMING_SIZE];
+static volatile uint32_t timing_head = 0;
+static volatile uint32_t timing_tail = 0;
+
+// Frame in progress (interrupt side)
+static uint32_t frame_start_us;
+static uint8_t frame_acks;
+static bool frame_started = false;
+
+// Frame being assembled (main loop side)
+static uint8_t frame_cmd[SNIFFER_MAX_FRAME_BYTES];
+static uint8_t frame_data[SNIFFER_MAX_FRAME_BYTES];
+static uint16_t frame_len = 0;
+static bool discard = false;
+
+static SNIFFER_STATS_t stats;
+
+static uint16_t program_instr[14];
+
+// Total words written to the ring (wraps at 2^32)
+static inline uint32_t ring_position(void) {
+  return dma_base +
+         (SNIFFER_DMA_COUNT - dma_channel_hw_addr(dma_chan)->transfer_count);
+}
+
+static void __not_in_flash_func(bus_irq)(uint gpio, uint32_t events) {
+  uint32_t now = time_us_32();
+
+  if (gpio == PIN_ACK) {
+    frame_acks++;
+    return;
+  }
+
+  if (events & GPIO_IRQ_EDGE_FALL) {
+    frame_start_us = now;
+    frame_acks = 0;
+    frame_started = true;
+  }
+  if (events & GPIO_IRQ_EDGE_RISE) {
+    uint32_t head = timing_head;
+
+    if (head - timing_tail < SNIFFER_TIMING_SIZE) {
+      FRAME_TIMING_t *timing = &timing_ring[head & (SNIFFER_TIMING_SIZE - 1)];
+      timing->start_us = frame_started ? frame_start_us : now;
+      timing->end_word = ring_position();
+      timing->duration_us = now - timing->start_us;
+      timing->ack_count = frame_acks;
+      timing->flags = frame_started ? 0 : SNIFFER_FLAG_NO_START;
+      timing_head = head + 1;
+    }
+    // A lost record shows up as an unmatched frame
+    frame_started = false;
+  }
+}
+
+static uint pio_program_load(void) {
+  enum { PC_FRAME = 0, PC_LOW = 1, PC_END = 10 };
+
+  // Built at runtime so that pin numbers come from psx_controller.h
+  program_instr[0] = pio_encode_wait_gpio(false, PIN_CS);  // frame start
+  program_instr[1] = pio_encode_jmp_pin(PC_END);           // CS released
+  program_instr[2] = pio_encode_mov(pio_osr, pio_pins);    // SCK still high?
+  program_instr[3] = pio_encode_out(pio_x, 1);
+  program_instr[4] = pio_encode_jmp_x_dec(PC_LOW);
+  program_instr[5] = pio_encode_wait_gpio(true, PIN_SCK);  // rising edge
+  program_instr[6] = pio_encode_mov(pio_osr, pio_pins);
+  program_instr[7] = pio_encode_out(pio_null, 1);          // drop SCK
+  program_instr[8] = pio_encode_in(pio_osr, 2);            // MOSI, MISO
+  program_instr[9] = pio_encode_jmp(PC_LOW);
+  program_instr[10] = pio_encode_mov_not(pio_isr, pio_null);  // marker
+  program_instr[11] = pio_encode_in(pio_y, 15);
+  program_instr[12] = pio_encode_push(false, true);
+  program_instr[13] = pio_encode_jmp_y_dec(PC_FRAME);
+
+  const pio_program_t program = {
+      .instructions = program_instr,
+      .length = count_of(program_instr),
+      .origin = -1,
+  };
+  return pio_add_program(SNIFFER_PIO, &program);
+}
+
+void psx_sniffer_init(void) {
+  const uint pins[] = {PIN_MISO, PIN_MOSI, PIN_SCK, PIN_CS, PIN_ACK};
+  uint i;
+
+  // Inputs only: the console and the pad drive the bus
+  for (i = 0; i < count_of(pins); i++) {
+    gpio_init(pins[i]);
+    gpio_disable_pulls(pins[i]);
+  }
+
+  uint offset = pio_program_load();
+  uint sm = pio_claim_unused_sm(SNIFFER_PIO, true);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_in_pins(&c, PIN_SCK);
+  sm_config_set_jmp_pin(&c, PIN_CS);
+  sm_config_set_wrap(&c, offset, offset + count_of(program_instr) - 1);
+  // PSX is LSB first: shift right, autopush after 8 bit pairs
+  sm_config_set_in_shift(&c, true, true, 16);
+  sm_config_set_out_shift(&c, true, false, 32);
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+  pio_sm_init(SNIFFER_PIO, sm, offset, &c);
+  pio_sm_exec(SNIFFER_PIO, sm, pio_encode_set(pio_y, 0));
+
+  dma_chan = dma_claim_unused_channel(true);
+  dma_channel_config d = dma_channel_get_default_config(dma_chan);
+  channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+  channel_config_set_read_increment(&d, false);
+  channel_config_set_write_increment(&d, true);
+  channel_config_set_ring(&d, true, SNIFFER_RING_BITS);
+  channel_config_set_dreq(&d, pio_get_dreq(SNIFFER_PIO, sm, false));
+  dma_channel_configure(dma_chan, &d, ring, &SNIFFER_PIO->rxf[sm],
+                        SNIFFER_DMA_COUNT, true);
+
+  gpio_set_irq_enabled_with_callback(
+      PIN_CS, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, &bus_irq);
+  gpio_set_irq_enabled(PIN_ACK, GPIO_IRQ_EDGE_FALL, true);
+
+  pio_sm_set_enabled(SNIFFER_PIO, sm, true);
+}
+
+// Total words written to the ring, re-arms the DMA when done (main loop)
+static uint32_t ring_written(void) {
+  // 2^32 - 1 words done (weeks of capture): continue at the same address
+  if (dma_channel_hw_addr(dma_chan)->transfer_count == 0 &&
+      !dma_channel_is_busy(dma_chan)) {
+    dma_base += SNIFFER_DMA_COUNT;
+    dma_channel_set_trans_count(dma_chan, SNIFFER_DMA_COUNT, true);
+  }
+  return ring_position();
+}
+
+static bool is_marker(uint32_t word) {
+  return (word & SNIFFER_MARKER_MASK) == SNIFFER_MARKER_MASK;
+}
+
+// Timing of the frame whose marker is at ring position `marker`:
+// the record taken at the first CS release after the marker was written.
+// The DMA may still hold the marker when the interrupt runs (end_word ==
+// marker), and the interrupt may be late (end_word further on, but no
+// other marker in between).
+// 1: found, 0: not recorded yet, -1: lost
+static int match_timing(uint32_t marker, FRAME_TIMING_t *timing) {
+  while (timing_tail != timing_head) {
+    const FRAME_TIMING_t *t =
+        &timing_ring[timing_tail & (SNIFFER_TIMING_SIZE - 1)];
+    int32_t ahead = (int32_t)(t->end_word - marker);
+    uint32_t pos;
+
+    if (ahead < 0) {
+      // Earlier CS pulse the PIO did not see as a frame (or data lost)
+      stats.unmatched++;
+      timing_tail++;
+      continue;
+    }
+    if (ahead > SNIFFER_RING_WORDS) {
+      return -1;  // frames in between already overwritten
+    }
+    for (pos = marker + 1; pos < t->end_word; pos++) {
+      if (is_marker(ring[pos & (SNIFFER_RING_WORDS - 1)])) {
+        return -1;  // record of a later frame: this one's timing was lost
+      }
+    }
+    *timing = *t;
+    timing_tail++;
+    return 1;
+  }
+  return 0;
+}
+
+static void send_record(const SNIFFER_HEADER_t *header, const void *payload1,
+                        const void *payload2, uint16_t payload_len) {
+  tud_vendor_write(header, sizeof(*header));
+  tud_vendor_write(payload1, payload_len);
+  if (payload2 != NULL) {
+    tud_vendor_write(payload2, payload_len);
+  }
+  tud_vendor_write_flush();
+}
+
+static void init_header(SNIFFER_HEADER_t *header, uint8_t type) {
+  memset(header, 0, sizeof(*header));
+  header->sync[0] = SNIFFER_SYNC0;
+  header->sync[1] = SNIFFER_SYNC1;
+  header->type = type;
+}
+
+static void send_frame(uint16_t seq, const FRAME_TIMING_t *timing) {
+  SNIFFER_HEADER_t header;
+  uint16_t length = frame_len;
+
+  init_header(&header, SNIFFER_REC_FRAME);
+  header.flags = timing->flags;
+  if (length > SNIFFER_MAX_FRAME_BYTES) {
+    length = SNIFFER_MAX_FRAME_BYTES;
+    header.flags |= SNIFFER_FLAG_TRUNCATED;
+  }
+  header.length = length;
+  header.seq = seq;
+  header.time_us = timing->start_us;
+  header.duration_us = timing->duration_us;
+  header.ack_count = timing->ack_count;
+
+  // Backpressure: drop whole frames, never stall the capture
+  if (!tud_vendor_mounted() ||
+      tud_vendor_write_available() < sizeof(header) + 2 * length) {
+    stats.usb_dropped++;
+    return;
+  }
+  send_record(&header, frame_cmd, frame_data, length);
+  stats.frames++;
+}
+
+static void send_stats(void) {
+  SNIFFER_HEADER_t header;
+
+  init_header(&header, SNIFFER_REC_STATS);
+  header.length = sizeof(stats);
+  header.time_us = time_us_32();
+
+  if (tud_vendor_mounted() &&
+      tud_vendor_write_available() >= sizeof(header) + sizeof(stats)) {
+    send_record(&header, &stats, NULL, sizeof(stats));
+  }
+}
+
+// Split one capture word into the MOSI (command) and MISO (data) bytes
+static void add_byte(uint32_t word) {
+  uint8_t cmd = 0;
+  uint8_t data = 0;
+  int i;
+
+  if (frame_len < SNIFFER_MAX_FRAME_BYTES) {
+    word >>= 16;
+    for (i = 0; i < 8; i++) {
+      cmd |= (word & 1) << i;
+      data |= ((word >> 1) & 1) << i;
+      word >>= 2;
+    }
+    frame_cmd[frame_len] = cmd;
+    frame_data[frame_len] = data;
+  }
+  if (frame_len < UINT16_MAX) frame_len++;
+}
+
+void psx_sniffer_task(void) {
+  static uint32_t stats_ms = 0;
+  uint32_t written = ring_written();
+  uint32_t pending = written - read_count;
+
+  if (pending > stats.ring_high_water) stats.ring_high_water = pending;
+
+  if (pending > SNIFFER_RING_WORDS) {
+    // Overwritten before read: skip to the next complete frame
+    stats.ring_overruns++;
+    read_count = written;
+    frame_len = 0;
+    discard = true;
+  }
+
+  while (read_count != written) {
+    uint32_t word = ring[read_count & (SNIFFER_RING_WORDS - 1)];
+
+    if (!is_marker(word)) {
+      add_byte(word);
+      read_count++;
+      continue;
+    }
+
+    FRAME_TIMING_t timing;
+    uint16_t seq = (0 - (word >> 17)) & SNIFFER_SEQ_MASK;
+    int found = match_timing(read_count, &timing);
+
+    if (found == 0) {
+      break;  // CS interrupt not serviced yet: retry next time
+    }
+    read_count++;
+
+    if (discard) {
+      discard = false;
+    } else if (found < 0) {
+      stats.unmatched++;
+    } else {
+      send_frame(seq, &timing);
+    }
+    frame_len = 0;
+  }
+
+  if (board_millis() - stats_ms >= SNIFFER_STATS_INTERVAL_MS) {
+    stats_ms = board_millis();
+    send_stats();
+  }
+}
+
+#endif
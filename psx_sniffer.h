@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Passive PSX bus sniffer (PSX_SNIFFER build)
+// The PSX port pins (psx_controller.h) are only read: a console drives
+// SCK/MOSI/CS and the pad drives MISO/ACK. Each CS-low period is captured
+// as one frame and streamed on the vendor bulk IN endpoint.
+// Decode with tools/psx_sniff.
+
+// Longer frames (memory card sector read is 140 bytes) are truncated
+#define SNIFFER_MAX_FRAME_BYTES 160
+
+// Statistics record interval
+#define SNIFFER_STATS_INTERVAL_MS 1000
+
+// Wire format: SNIFFER_HEADER_t + payload (little endian)
+#define SNIFFER_SYNC0 0x5a
+#define SNIFFER_SYNC1 0xa5
+
+#define SNIFFER_REC_FRAME 0x01  // payload: cmd[length], data[length]
+#define SNIFFER_REC_STATS 0x02  // payload: SNIFFER_STATS_t
+
+// SNIFFER_HEADER_t.flags
+#define SNIFFER_FLAG_TRUNCATED 0x01  // frame longer than the payload
+#define SNIFFER_FLAG_NO_START 0x02   // capture started mid-frame
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync[2];
+  uint8_t type;          // SNIFFER_REC_*
+  uint8_t flags;         // SNIFFER_FLAG_*
+  uint16_t length;       // frame: bytes per direction, stats: payload size
+  uint16_t seq;          // frame number (15 bits)
+  uint32_t time_us;      // CS asserted
+  uint16_t duration_us;  // CS asserted -> released
+  uint8_t ack_count;     // ACK pulses from the pad
+  uint8_t reserved;
+} SNIFFER_HEADER_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t frames;          // frames sent to the host
+  uint32_t usb_dropped;     // frames dropped: host not reading fast enough
+  uint32_t ring_overruns;   // capture ring overflowed (frames lost)
+  uint32_t unmatched;       // frames without timing (or timing without data)
+  uint32_t ring_high_water; // max capture ring fill (words)
+} SNIFFER_STATS_t;
+
+#ifdef PSX_SNIFFER
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void psx_sniffer_init(void);
+void psx_sniffer_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
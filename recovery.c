@@ -0,0 +1,103 @@
+/*
+    Watchdog-backed fault recovery
+
+    Scratch register layout (scratch[4..7] belong to the SDK / bootrom):
+      scratch[0]  RECOVERY_MAGIC
+      scratch[1]  MAC bytes 0-3
+      scratch[2]  MAC bytes 4-5 | USB mode << 16 | session << 24
+      scratch[3]  watchdog reset count
+    session = SW_STATE_t | SESSION_IMU (IMU enabled by the host) |
+              SESSION_VALID, written once the MAC is settled.
+*/
+
+#include "recovery.h"
+
+#include "hardware/watchdog.h"
+#include "pc_controller.h"
+#include "sw_controller.h"
+#include "sw_state.h"
+
+#define SESSION_VALID 0x80
+#define SESSION_IMU 0x40
+
+static RECOVERY_STATUS_t status;
+static bool armed = false;
+static bool held = false;
+
+bool recovery_init(void) {
+  io_rw_32 *scratch = watchdog_hw->scratch;
+  uint8_t session;
+
+  if (!watchdog_caused_reboot() || scratch[0] != RECOVERY_MAGIC) {
+    // Power-up or reset by other means: start a new count
+    scratch[0] = RECOVERY_MAGIC;
+    scratch[2] = 0;
+    scratch[3] = 0;
+    return false;
+  }
+
+  status.watchdog_resets = ++scratch[3];
+  session = scratch[2] >> 24;
+  if (!(session & SESSION_VALID)) {
+    return false;  // hung before the first mount
+  }
+
+  mac_addr[0] = scratch[1];
+  mac_addr[1] = scratch[1] >> 8;
+  mac_addr[2] = scratch[1] >> 16;
+  mac_addr[3] = scratch[1] >> 24;
+  mac_addr[4] = scratch[2];
+  mac_addr[5] = scratch[2] >> 8;
+  g_usb_mode = scratch[2] >> 16;
+
+  status.saved_state = session & ~(SESSION_VALID | SESSION_IMU);
+  status.recovered = true;
+
+  // Was streaming: send input right after mount, the host keeps the session
+  if (status.saved_state == SW_STATE_INPUT ||
+      status.saved_state == SW_STATE_RESUMING) {
+    sw_state_recover();
+    sw_set_imu_enabled(session & SESSION_IMU);
+  }
+  return true;
+}
+
+void recovery_arm(void) {
+  watchdog_enable(RECOVERY_WATCHDOG_MS, true);
+  armed = true;
+}
+
+void recovery_hold(uint32_t ms) {
+  if (!armed) return;
+  watchdog_enable(ms, true);
+  held = true;
+}
+
+static void save_session(void) {
+  io_rw_32 *scratch = watchdog_hw->scratch;
+  SW_STATE_t state = sw_state_get();
+  uint8_t session = state | SESSION_VALID;
+
+  // MAC is generated at the first mount; keep the last session while detached
+  if (state == SW_STATE_DETACHED) return;
+  if (sw_imu_enabled()) session |= SESSION_IMU;
+
+  scratch[1] = mac_addr[0] | (mac_addr[1] << 8) | (mac_addr[2] << 16) |
+               ((uint32_t)mac_addr[3] << 24);
+  scratch[2] = mac_addr[4] | (mac_addr[5] << 8) | (g_usb_mode << 16) |
+               ((uint32_t)session << 24);
+}
+
+void recovery_task(void) {
+  if (!armed) return;
+
+  if (held) {
+    watchdog_enable(RECOVERY_WATCHDOG_MS, true);
+    held = false;
+  } else {
+    watchdog_update();
+  }
+  save_session();
+}
+
+const RECOVERY_STATUS_t *recovery_status(void) { return &status; }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Watchdog-backed fault recovery
+// The main loop feeds the hardware watchdog. The host session (MAC, USB
+// mode, input streaming) is mirrored into the watchdog scratch registers,
+// which survive a watchdog reset: after a hang the device comes back with
+// the same MAC and mode, skips the boot-time mode selection and resumes
+// streaming right after re-enumeration.
+//
+// Feature report RECOVERY_STATUS_REPORT_ID (GET only): RECOVERY_STATUS_t
+
+#define RECOVERY_STATUS_REPORT_ID 0xf2
+
+#define RECOVERY_WATCHDOG_MS 100  // main loop stall -> reset
+#define RECOVERY_MAGIC 0x50535752  // "PSWR"
+
+typedef struct __attribute__((packed)) {
+  uint32_t watchdog_resets;  // since power-up
+  uint8_t recovered;         // this boot restored the previous session
+  uint8_t saved_state;       // SW_STATE_t when the watchdog fired
+  uint8_t reserved[2];
+} RECOVERY_STATUS_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Call early in main(): true if the previous session was restored
+bool recovery_init(void);
+// Start the watchdog (after boot-time work)
+void recovery_arm(void);
+// Feed the watchdog and save the session (every main loop pass)
+void recovery_task(void);
+// Allow `ms` until the next recovery_task() (known slow work, e.g. flash)
+void recovery_hold(uint32_t ms);
+const RECOVERY_STATUS_t *recovery_status(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,159 @@
+/*
+    Runtime settings (vendor HID configuration channel)
+*/
+
+#include "settings.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "hardware/flash.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "recovery.h"
+#include "sw_controller.h"
+
+// Last flash sector
+#define SETTINGS_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+// Watchdog allowance for erase + program
+#define SETTINGS_FLASH_HOLD_MS 1000
+
+SETTINGS_t g_settings;
+
+static SETTINGS_t pending_settings;
+static volatile bool pending = false;
+static volatile uint8_t pending_cmd = 0;
+
+static const SETTINGS_t default_settings = {
+    .magic = SETTINGS_MAGIC,
+    .version = SETTINGS_VERSION,
+    .size = sizeof(SETTINGS_t),
+    .report_interval_ms = SW_REPORT_INTERVAL_MS,
+    .button_layout = SETTINGS_LAYOUT_MODE_PIN,
+    .spi_speed_khz = SPI_SPEED_KHZ,
+    .stick_deadzone = 0,
+    .stick_filter = 1,
+    .imu_mode = SETTINGS_IMU_OFF,
+};
+
+uint16_t settings_crc(const SETTINGS_t *settings) {
+  const uint8_t *data = (const uint8_t *)settings;
+  uint16_t crc = 0xffff;
+  size_t i;
+  int bit;
+
+  for (i = 0; i < offsetof(SETTINGS_t, crc); i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static bool settings_valid(const SETTINGS_t *settings) {
+  return settings->magic == SETTINGS_MAGIC &&
+         settings->version == SETTINGS_VERSION &&
+         settings->size == sizeof(SETTINGS_t) &&
+         settings->report_interval_ms >= 1 &&
+         settings->report_interval_ms <= 50 &&
+         settings->button_layout <= SETTINGS_LAYOUT_TAIKO &&
+         settings->spi_speed_khz >= 50 && settings->spi_speed_khz <= 1000 &&
+         settings->stick_deadzone < 0x80 && settings->stick_filter <= 1 &&
+         settings->imu_mode <= SETTINGS_IMU_R3;
+}
+
+static bool load_from_flash(SETTINGS_t *settings) {
+  const SETTINGS_t *stored =
+      (const SETTINGS_t *)(XIP_BASE + SETTINGS_FLASH_OFFSET);
+
+  if (!settings_valid(stored) || settings_crc(stored) != stored->crc) {
+    return false;
+  }
+  memcpy(settings, stored, sizeof(SETTINGS_t));
+  return true;
+}
+
+static void save_to_flash(const SETTINGS_t *settings) {
+  uint8_t page[FLASH_PAGE_SIZE];
+
+  memset(page, 0xff, sizeof(page));
+  memcpy(page, settings, sizeof(SETTINGS_t));
+
+  // Sector erase takes up to 400 ms: longer than the watchdog period
+  recovery_hold(SETTINGS_FLASH_HOLD_MS);
+
+  // XIP is unavailable while erasing/programming
+  uint32_t irq = save_and_disable_interrupts();
+  flash_range_erase(SETTINGS_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+  flash_range_program(SETTINGS_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+  restore_interrupts(irq);
+}
+
+void settings_init(void) {
+  if (!load_from_flash(&g_settings)) {
+    g_settings = default_settings;
+    g_settings.crc = settings_crc(&g_settings);
+  }
+}
+
+bool settings_request(const uint8_t *buf, uint16_t len) {
+  SETTINGS_t settings;
+
+  if (len < sizeof(SETTINGS_t)) {
+    return false;
+  }
+  memcpy(&settings, buf, sizeof(SETTINGS_t));
+  if (!settings_valid(&settings)) {
+    return false;
+  }
+  settings.crc = settings_crc(&settings);
+
+  pending_settings = settings;
+  pending = true;
+  return true;
+}
+
+bool settings_apply_pending(void) {
+  if (!pending) {
+    return false;
+  }
+  pending = false;
+
+  if (pending_settings.spi_speed_khz != g_settings.spi_speed_khz) {
+    spi_set_baudrate(SPI_PORT, pending_settings.spi_speed_khz * 1000);
+  }
+  g_settings = pending_settings;
+  return true;
+}
+
+void settings_command(uint8_t cmd) { pending_cmd = cmd; }
+
+void settings_task(void) {
+  uint8_t cmd = pending_cmd;
+  SETTINGS_t settings;
+
+  if (cmd == 0) {
+    return;
+  }
+  pending_cmd = 0;
+
+  switch (cmd) {
+    case SETTINGS_CMD_SAVE:
+      save_to_flash(&g_settings);
+      break;
+
+    case SETTINGS_CMD_DEFAULTS:
+      settings = default_settings;
+      settings_request((const uint8_t *)&settings, sizeof(settings));
+      break;
+
+    case SETTINGS_CMD_RELOAD:
+      if (load_from_flash(&settings)) {
+        settings_request((const uint8_t *)&settings, sizeof(settings));
+      }
+      break;
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Runtime settings
+// Read/written by the host through vendor HID reports (see usb_descriptors.c)
+// and optionally saved to the last flash sector.
+//
+// Feature report SETTINGS_REPORT_ID:  GET = active block, SET = new block
+//                                     (applied between two reports)
+// Output report SETTINGS_CMD_REPORT_ID: byte 1 = SETTINGS_CMD_*
+
+#define SETTINGS_REPORT_ID 0xf0
+#define SETTINGS_CMD_REPORT_ID 0xf1
+
+#define SETTINGS_CMD_SAVE 0x01      // write active settings to flash
+#define SETTINGS_CMD_DEFAULTS 0x02  // restore build-time defaults
+#define SETTINGS_CMD_RELOAD 0x03    // reload from flash
+
+#define SETTINGS_MAGIC 0x5350  // "PS"
+#define SETTINGS_VERSION 1
+
+// button_layout
+#define SETTINGS_LAYOUT_MODE_PIN 0  // follow MODE switch
+#define SETTINGS_LAYOUT_PROCON 1
+#define SETTINGS_LAYOUT_TAIKO 2
+
+// imu_mode (see imu_synth.h)
+#define SETTINGS_IMU_OFF 0     // IMU section left zero
+#define SETTINGS_IMU_STICK 1   // right stick drives the gyro
+#define SETTINGS_IMU_R3 2      // right stick drives the gyro while R3 is held
+
+typedef struct __attribute__((packed)) {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t size;                // sizeof(SETTINGS_t)
+  uint8_t report_interval_ms;  // Switch 0x30 report interval (1-50)
+  uint8_t button_layout;       // SETTINGS_LAYOUT_*
+  uint16_t spi_speed_khz;      // PSX bus clock (50-1000)
+  uint8_t stick_deadzone;      // PSX counts around center, 0 = off
+  uint8_t stick_filter;        // 0 = raw sticks, 1 = filtered
+  uint8_t imu_mode;            // SETTINGS_IMU_*
+  uint8_t reserved[3];
+  uint16_t crc;                // CRC-16/CCITT of the bytes above
+} SETTINGS_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void settings_init(void);
+// Validate and queue a new block; false if rejected
+bool settings_request(const uint8_t *buf, uint16_t len);
+// Apply queued block; true if something changed (call between reports)
+bool settings_apply_pending(void);
+void settings_command(uint8_t cmd);
+// Deferred flash work (call from main loop)
+void settings_task(void);
+uint16_t settings_crc(const SETTINGS_t *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+extern SETTINGS_t g_settings;
@@ -0,0 +1,126 @@
+/*
+    Analog stick noise filter
+*/
+
+#include "stick_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+void stick_filter_reset(STICK_FILTER_t *filter) {
+  memset(filter, 0, sizeof(STICK_FILTER_t));
+}
+
+static inline void update_axis(STICK_AXIS_t *axis, uint8_t sample) {
+  int32_t delta = ((int32_t)sample << 8) - axis->value;
+  int32_t abs_delta = (delta < 0) ? -delta : delta;
+
+  axis->speed += (abs_delta - axis->speed) >> STICK_FILTER_SPEED_ALPHA_SHIFT;
+
+  int32_t alpha =
+      STICK_FILTER_ALPHA_MIN + (axis->speed >> STICK_FILTER_SPEED_SHIFT);
+  if (alpha > 256) {
+    alpha = 256;
+  }
+
+  axis->value += (delta * alpha) >> 8;
+}
+
+void __not_in_flash_func(stick_filter_update)(STICK_FILTER_t *filter,
+                                              const uint8_t *sample) {
+  int i;
+
+  if (!filter->primed) {
+    for (i = 0; i < STICK_AXIS_COUNT; i++) {
+      filter->axis[i].value = (int32_t)sample[i] << 8;
+      filter->axis[i].speed = 0;
+    }
+    filter->primed = true;
+    return;
+  }
+
+  for (i = 0; i < STICK_AXIS_COUNT; i++) {
+    update_axis(&filter->axis[i], sample[i]);
+  }
+}
+
+void __not_in_flash_func(stick_filter_get)(const STICK_FILTER_t *filter,
+                                           uint8_t *out) {
+  int i;
+
+  for (i = 0; i < STICK_AXIS_COUNT; i++) {
+    int32_t value = (filter->axis[i].value + 0x80) >> 8;  // round
+    if (value < 0) value = 0;
+    if (value > 255) value = 255;
+    out[i] = value;
+  }
+}
+
+#ifdef STICK_FILTER_BENCH
+//--------------------------------------------------------------------+
+// Benchmark (printed to stdio UART)
+//--------------------------------------------------------------------+
+#define BENCH_ITERATIONS 10000
+
+void stick_filter_benchmark(void) {
+  STICK_FILTER_t filter;
+  uint8_t sample[STICK_AXIS_COUNT];
+  uint8_t out[STICK_AXIS_COUNT];
+  int i;
+
+  // Cost per sample (4 axes), pseudo noisy input
+  stick_filter_reset(&filter);
+  uint32_t seed = 1;
+  uint32_t start_us = time_us_32();
+  for (i = 0; i < BENCH_ITERATIONS; i++) {
+    seed = seed * 1103515245 + 12345;
+    memset(sample, 0x80 + ((seed >> 16) & 0x07) - 4, sizeof(sample));
+    stick_filter_update(&filter, sample);
+  }
+  uint32_t elapsed_us = time_us_32() - start_us;
+  stick_filter_get(&filter, out);
+  printf("stick_filter: %lu ns/sample (%d samples)\n",
+         (unsigned long)(elapsed_us * 1000 / BENCH_ITERATIONS),
+         BENCH_ITERATIONS);
+
+  // Added lag: full-scale step, count samples until output reaches 90%
+  stick_filter_reset(&filter);
+  memset(sample, 0x00, sizeof(sample));
+  stick_filter_update(&filter, sample);
+  memset(sample, 0xff, sizeof(sample));
+  for (i = 1; i <= 64; i++) {
+    stick_filter_update(&filter, sample);
+    stick_filter_get(&filter, out);
+    if (out[0] >= 230) break;
+  }
+  printf("stick_filter: step lag %d samples (%d us)\n", i - 1,
+         (i - 1) * STICK_OVERSAMPLE_INTERVAL_US);
+
+  // Added lag on a ramp (8 counts/sample, ~1/16 full scale per 4 ms)
+  stick_filter_reset(&filter);
+  for (i = 0; i < 24; i++) {
+    memset(sample, i * 8, sizeof(sample));
+    stick_filter_update(&filter, sample);
+  }
+  stick_filter_get(&filter, out);
+  printf("stick_filter: ramp lag %d counts (%d us)\n", sample[0] - out[0],
+         (sample[0] - out[0]) * STICK_OVERSAMPLE_INTERVAL_US / 8);
+
+  // Residual jitter: +-3 counts around center
+  stick_filter_reset(&filter);
+  uint8_t min = 0xff, max = 0;
+  for (i = 0; i < 1000; i++) {
+    seed = seed * 1103515245 + 12345;
+    memset(sample, 0x80 + ((seed >> 16) % 7) - 3, sizeof(sample));
+    stick_filter_update(&filter, sample);
+    stick_filter_get(&filter, out);
+    if (i >= 100) {
+      if (out[0] < min) min = out[0];
+      if (out[0] > max) max = out[0];
+    }
+  }
+  printf("stick_filter: jitter in 7 counts -> out %d counts\n", max - min + 1);
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Analog stick oversampling
+// Sticks are sampled every STICK_OVERSAMPLE_INTERVAL_US between reports and
+// each axis is run through an adaptive (1-euro style) fixed point filter:
+// slow movement (pot jitter) is smoothed heavily, fast movement passes
+// through almost unfiltered.
+
+#define STICK_OVERSAMPLE_INTERVAL_US 2000
+
+// Filter coefficient in 1/256 units
+#define STICK_FILTER_ALPHA_MIN 16      // at rest
+#define STICK_FILTER_SPEED_SHIFT 6     // speed (8.8 fixed) -> extra alpha
+#define STICK_FILTER_SPEED_ALPHA_SHIFT 2  // speed estimator smoothing (1/4)
+
+// PSX axis order: RX RY LX LY (psx_recv[3..6])
+#define STICK_AXIS_COUNT 4
+
+typedef struct {
+  int32_t value;  // filtered value (8.8 fixed point)
+  int32_t speed;  // smoothed |input - value| (8.8 fixed point)
+} STICK_AXIS_t;
+
+typedef struct {
+  STICK_AXIS_t axis[STICK_AXIS_COUNT];
+  bool primed;
+} STICK_FILTER_t;
+
+void stick_filter_reset(STICK_FILTER_t *filter);
+void stick_filter_update(STICK_FILTER_t *filter, const uint8_t *sample);
+void stick_filter_get(const STICK_FILTER_t *filter, uint8_t *out);
+
+#ifdef STICK_FILTER_BENCH
+void stick_filter_benchmark(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,9 @@
 
 #include "bsp/board.h"
 #include "pico/stdlib.h"
+#include "sw_state.h"
+#include "trace_log.h"
+#include "tusb.h"
 
 // SPI flash data (from 0x6000)
 const uint8_t spi_factory_calib_data[] = {
@@ -53,31 +56,35 @@ const uint8_t spi_factory_calib_data[] = {
     0xff,
     0xff,
     0xff,
-    // 0x20-0x37: 6-axis motion sensor calib
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
-    0xff,
+    // 0x20-0x37: 6-axis motion sensor calib (matches imu_synth.c)
+    // accel origin X, Y, Z (int16, level = 0)
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    // accel sensitivity X, Y, Z (16384: 1G = 4096 counts)
+    0x00,
+    0x40,
+    0x00,
+    0x40,
+    0x00,
+    0x40,
+    // gyro origin X, Y, Z
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    // gyro sensitivity X, Y, Z (13371: 1 count = 0.07 dps)
+    0x3b,
+    0x34,
+    0x3b,
+    0x34,
+    0x3b,
+    0x34,
     // 0x38-0x3c: padding
     0xff,
     0xff,
@@ -261,22 +268,36 @@ const uint8_t spi_user_calib_data[] = {
     0xFF,
 };
 
-const uint8_t sw_initial_input_report[11] = {0x81, 0x00, 0x00, 0x00, 0xf0, 0x07,
-                                             0x7f, 0xf0, 0x07, 0x7f, 0x0c};
+// Copied into every input report: kept in SRAM, not read through XIP
+const uint8_t __not_in_flash("sw_initial_input_report")
+    sw_initial_input_report[SW_INPUT_STATE_SIZE] = {
+        0x81, 0x00, 0x00, 0x00, 0xf0, 0x07, 0x7f, 0xf0, 0x07, 0x7f, 0x0c};
+
+// Latest input state (connection info .. vibrator byte)
+// Embedded into every 0x30 / 0x21 report at transmit time
+static uint8_t sw_input_state[SW_INPUT_STATE_SIZE] = {
+    0x81, 0x00, 0x00, 0x00, 0xf0, 0x07, 0x7f, 0xf0, 0x07, 0x7f, 0x0c};
+
+// Latest IMU samples, embedded into 0x30 reports once the host enabled IMU
+static uint8_t sw_imu_state[SW_IMU_SIZE];
+static bool imu_enabled = false;
 
 uint8_t mac_addr[6];
 
+static inline uint8_t sw_timer(void) { return (board_millis() / 10) % 256; }
+
 void init_sw_module(void) {
   int i;
-  srand(board_millis());
+  srand(time_us_32());
 
   for (i = 0; i < sizeof(mac_addr); i++) {
     mac_addr[i] = rand() % 256;
   }
 }
 
-void build_sw_report(SW_REPORT_t *report, uint8_t report_id, uint8_t cmd,
-                     const uint8_t *data, int len) {
+void __not_in_flash_func(build_sw_report)(SW_REPORT_t *report,
+                                          uint8_t report_id, uint8_t cmd,
+                                          const uint8_t *data, int len) {
   report->data[0] = cmd;
   memcpy(report->data + 1, data, len);
   memset(report->data + 1 + len, 0, SW_REPORT_SIZE - len - 1);
@@ -286,11 +307,11 @@ void build_sw_report(SW_REPORT_t *report, uint8_t report_id, uint8_t cmd,
 
 static void build_uart_report(SW_REPORT_t *report, uint8_t code, uint8_t subcmd,
                               const uint8_t *data, uint8_t len) {
-  build_sw_report(report, 0x21, (board_millis() / 10) % 256, NULL, 0);
+  build_sw_report(report, 0x21, sw_timer(), NULL, 0);
 
-  memcpy(report->data + report->len, sw_initial_input_report,
-         sizeof(sw_initial_input_report));
-  report->len += sizeof(sw_initial_input_report);
+  // Input part is refreshed with the latest state in sw_tx_task()
+  memcpy(report->data + report->len, sw_input_state, sizeof(sw_input_state));
+  report->len += sizeof(sw_input_state);
   report->data[report->len++] = code;
   report->data[report->len++] = subcmd;
   memcpy(report->data + report->len, data, len);
@@ -374,10 +395,14 @@ void handle_subcommand(SW_REPORT_t *report, const uint8_t *host_data,
     build_uart_report(report, 0x82, sub, dev_info, sizeof(dev_info));
   } break;
 
+  case 0x40: // Enable IMU
+    imu_enabled = host_data[11] != 0;
+    build_uart_report(report, 0x80, sub, NULL, 0);
+    break;
+
   case 0x03: // Set input report mode
   case 0x08: // Set shipment low power state
   case 0x38: // Set HOME light
-  case 0x40: // Enable IMU
   case 0x48: // Enable vibration
     build_uart_report(report, 0x80, sub, NULL, 0);
     break;
@@ -422,6 +447,9 @@ void handle_80_command(SW_REPORT_t *report, const uint8_t *host_data,
                        const uint16_t host_data_size) {
   uint8_t sub0 = host_data[1];
 
+  // New handshake: IMU stays off until this host enables it
+  if (sub0 >= 0x01 && sub0 <= 0x03) imu_enabled = false;
+
   switch (sub0) {
   case 0x01: { // Current connection status
     uint8_t mac_data[] = {0x00, 0x03, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa};
@@ -438,7 +466,6 @@ void handle_80_command(SW_REPORT_t *report, const uint8_t *host_data,
     break;
 
   case 04: // Only talk over USB HID without timeouts
-    g_input_enable = true;
     break;
   }
 }
@@ -447,6 +474,12 @@ void handle_host_data(SW_REPORT_t *report, const uint8_t *host_data,
                       const uint16_t host_data_size) {
   uint8_t cmd = host_data[0];
 
+  TRACE(TRACE_EV_HOST_DATA, cmd,
+        (cmd == 0x01 && host_data_size > 10) ? host_data[10] : host_data[1]);
+
+  // Input enable is driven by the session state machine
+  sw_state_host_data(cmd, host_data_size > 1 ? host_data[1] : 0);
+
   switch (cmd) {
   case 0x80:
     handle_80_command(report, host_data, host_data_size);
@@ -457,3 +490,183 @@ void handle_host_data(SW_REPORT_t *report, const uint8_t *host_data,
     break;
   }
 }
+
+//--------------------------------------------------------------------+
+// Transmit queue
+//--------------------------------------------------------------------+
+// Single producer (tud_task -> set_report callback) / single consumer
+// (sw_tx_task). Subcommand replies are queued and never dropped; they are
+// sent ahead of the 0x30 input frame. The input frame itself is not queued:
+// only a pending flag is kept, and the report is built from the latest
+// input state when the endpoint becomes free, so it is never stale.
+
+// The host waits for the reply to each command before sending the next one,
+// so at most SW_TX_MAX_OUTSTANDING replies are queued; the rest of the
+// queue is headroom for commands the host re-sends when a reply is late.
+// Backpressure: a command that arrives while the queue is full is held
+// (raw, in order) and handled once sw_tx_task() has freed a slot, so its
+// reply and side effects are never lost.
+#define SW_TX_MAX_OUTSTANDING 1
+#define SW_TX_QUEUE_SIZE 8  // must be power of 2 (uint8_t indices wrap)
+#define SW_RX_HOLD_SIZE 8   // must be power of 2
+
+_Static_assert((SW_TX_QUEUE_SIZE & (SW_TX_QUEUE_SIZE - 1)) == 0 &&
+                   SW_TX_QUEUE_SIZE <= 256,
+               "SW_TX_QUEUE_SIZE must be a power of 2 up to 256");
+_Static_assert(SW_TX_QUEUE_SIZE > SW_TX_MAX_OUTSTANDING,
+               "reply queue must hold the outstanding replies plus re-sends");
+_Static_assert((SW_RX_HOLD_SIZE & (SW_RX_HOLD_SIZE - 1)) == 0,
+               "SW_RX_HOLD_SIZE must be a power of 2");
+
+static SW_REPORT_t tx_reply_queue[SW_TX_QUEUE_SIZE];
+static volatile uint8_t tx_reply_head = 0;  // written by producer only
+static volatile uint8_t tx_reply_tail = 0;  // written by consumer only
+static volatile bool tx_input_pending = false;
+static uint32_t tx_reply_overflow = 0;
+
+// Host commands waiting for a reply slot (main loop only)
+static uint8_t rx_hold[SW_RX_HOLD_SIZE][SW_REPORT_SIZE];
+static uint8_t rx_hold_len[SW_RX_HOLD_SIZE];
+static uint8_t rx_hold_head = 0;
+static uint8_t rx_hold_tail = 0;
+
+static inline bool tx_reply_full(void) {
+  return (uint8_t)(tx_reply_head - tx_reply_tail) >= SW_TX_QUEUE_SIZE;
+}
+
+bool sw_queue_reply(const SW_REPORT_t *report) {
+  uint8_t head = tx_reply_head;
+
+  if (tx_reply_full()) {
+    tx_reply_overflow++;
+    return false;
+  }
+  tx_reply_queue[head % SW_TX_QUEUE_SIZE] = *report;
+  __asm volatile("" ::: "memory");
+  tx_reply_head = head + 1;
+
+  return true;
+}
+
+static void handle_command(const uint8_t *buf, uint16_t bufsize) {
+  SW_REPORT_t report;
+
+  memset(&report, 0, sizeof(report));
+  handle_host_data(&report, buf, bufsize);
+  // report_id stays 0 when the command needs no reply
+  if (report.report_id != 0) {
+    sw_queue_reply(&report);
+  }
+}
+
+// Held commands, oldest first, while reply slots are free
+static void handle_held_commands(void) {
+  while (rx_hold_tail != rx_hold_head && !tx_reply_full()) {
+    uint8_t slot = rx_hold_tail % SW_RX_HOLD_SIZE;
+
+    handle_command(rx_hold[slot], rx_hold_len[slot]);
+    rx_hold_tail++;
+  }
+}
+
+bool sw_host_command(const uint8_t *buf, uint16_t bufsize) {
+  uint8_t slot;
+
+  if (rx_hold_tail == rx_hold_head && !tx_reply_full()) {
+    handle_command(buf, bufsize);
+    return true;
+  }
+  if ((uint8_t)(rx_hold_head - rx_hold_tail) >= SW_RX_HOLD_SIZE) {
+    // Host sent SW_TX_QUEUE_SIZE + SW_RX_HOLD_SIZE commands without a
+    // single reply going out
+    tx_reply_overflow++;
+    return false;
+  }
+  if (bufsize > SW_REPORT_SIZE) bufsize = SW_REPORT_SIZE;
+  slot = rx_hold_head % SW_RX_HOLD_SIZE;
+  memcpy(rx_hold[slot], buf, bufsize);
+  rx_hold_len[slot] = bufsize;
+  rx_hold_head++;
+  return true;
+}
+
+void sw_update_input(const uint8_t *input) {
+  memcpy(sw_input_state, input, sizeof(sw_input_state));
+}
+
+void sw_update_imu(const uint8_t *imu) {
+  memcpy(sw_imu_state, imu, sizeof(sw_imu_state));
+}
+
+void sw_queue_input(void) { tx_input_pending = true; }
+
+uint32_t sw_tx_overflow_count(void) { return tx_reply_overflow; }
+
+bool sw_imu_enabled(void) { return imu_enabled; }
+
+void sw_set_imu_enabled(bool enabled) { imu_enabled = enabled; }
+
+// Host session is gone: drop pending replies / input, IMU back off
+void sw_tx_reset(void) {
+  tx_reply_tail = tx_reply_head;
+  rx_hold_tail = rx_hold_head;
+  tx_input_pending = false;
+  imu_enabled = false;
+}
+
+void __not_in_flash_func(sw_tx_task)(void) {
+  static bool tx_busy = false;
+  uint8_t tail;
+
+  // Commands held back while the queue was full
+  if (rx_hold_tail != rx_hold_head) handle_held_commands();
+  tail = tx_reply_tail;
+
+  if (!tud_hid_ready()) {
+    // Trace only the start of a busy period (this runs every loop pass)
+    if (!tx_busy) {
+      if (tail != tx_reply_head) {
+        TRACE(TRACE_EV_HID_NOT_READY,
+              tx_reply_queue[tail % SW_TX_QUEUE_SIZE].report_id, 0);
+        tx_busy = true;
+      } else if (tx_input_pending) {
+        TRACE(TRACE_EV_HID_NOT_READY, 0x30, 0);
+        tx_busy = true;
+      }
+    }
+    return;
+  }
+  tx_busy = false;
+
+  if (tail != tx_reply_head) {
+    SW_REPORT_t *report = &tx_reply_queue[tail % SW_TX_QUEUE_SIZE];
+
+    // 0x21 reply carries the latest input
+    if (report->report_id == 0x21) {
+      report->data[0] = sw_timer();
+      memcpy(report->data + 1, sw_input_state, sizeof(sw_input_state));
+    }
+    if (tud_hid_report(report->report_id, report->data, SW_REPORT_SIZE - 1)) {
+      TRACE(TRACE_EV_REPORT_SENT, report->report_id, report->data[0]);
+      __asm volatile("" ::: "memory");
+      tx_reply_tail = tail + 1;
+    }
+    return;
+  }
+
+  if (tx_input_pending) {
+    SW_REPORT_t report;
+    memset(&report, 0, sizeof(report));
+    build_sw_report(&report, 0x30, sw_timer(), sw_input_state,
+                    sizeof(sw_input_state));
+    if (imu_enabled) {
+      // Samples were packed between reports: copy only
+      memcpy(report.data + 1 + sizeof(sw_input_state), sw_imu_state,
+             sizeof(sw_imu_state));
+    }
+    if (tud_hid_report(report.report_id, report.data, SW_REPORT_SIZE - 1)) {
+      TRACE(TRACE_EV_REPORT_SENT, report.report_id, report.data[0]);
+      tx_input_pending = false;
+    }
+  }
+}
@@ -5,6 +5,11 @@
 
 #define SW_REPORT_SIZE 64
 #define SW_REPORT_INTERVAL_MS 12
+// connection info + buttons(3) + sticks(6) + vibrator
+#define SW_INPUT_STATE_SIZE 11
+// 0x30 IMU section: 3 samples of accel X Y Z, gyro X Y Z (int16 LE)
+#define SW_IMU_SAMPLES 3
+#define SW_IMU_SIZE (SW_IMU_SAMPLES * 12)
 
 typedef struct {
   uint8_t data[SW_REPORT_SIZE];
@@ -21,13 +26,33 @@ void handle_host_data(SW_REPORT_t *report, const uint8_t *buf,
                       uint16_t bufsize);
 void build_sw_report(SW_REPORT_t *report, uint8_t report_id, uint8_t cmd,
                      const uint8_t *data, int len);
+void handle_subcommand(SW_REPORT_t *report, const uint8_t *host_data,
+                       const uint16_t host_data_size);
+void handle_spi_flash_read(SW_REPORT_t *report, const uint8_t *host_data,
+                           const uint16_t host_data_size);
+
+// Transmit queue
+// Host command (OUT report): handled now, or held until a reply slot is
+// free; false only if the hold queue is full too
+bool sw_host_command(const uint8_t *buf, uint16_t bufsize);
+bool sw_queue_reply(const SW_REPORT_t *report);
+void sw_update_input(const uint8_t *input);
+void sw_update_imu(const uint8_t *imu);
+void sw_queue_input(void);
+void sw_tx_task(void);
+uint32_t sw_tx_overflow_count(void);
+void sw_tx_reset(void);
+// IMU reporting enabled by the host (subcommand 0x40)
+bool sw_imu_enabled(void);
+void sw_set_imu_enabled(bool enabled);
 
 #ifdef __cplusplus
 }
 #endif
 
-extern const uint8_t sw_initial_input_report[11];
+extern const uint8_t sw_initial_input_report[SW_INPUT_STATE_SIZE];
 extern bool g_input_enable;
+extern uint8_t mac_addr[6];
 
 // Switch Button Report Bitmap
 
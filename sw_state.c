@@ -0,0 +1,178 @@
+/*
+    Switch host session state machine
+
+    Keeps handshake state across USB suspend/resume and host resets.
+    After resume, 0x30 input is sent right away (the host usually keeps the
+    session); if the host does not talk within SW_RESUME_TIMEOUT_MS, the
+    device soft-reconnects so that the host redoes the handshake instead of
+    ignoring our reports until a physical replug. A handshake that never
+    starts or stops partway is retried the same way (SW_HANDSHAKE_TIMEOUT_MS).
+*/
+
+#include "sw_state.h"
+
+#include <stdio.h>
+
+#include "bsp/board.h"
+#include "pico/stdlib.h"
+#include "sw_controller.h"
+#include "trace_log.h"
+#include "tusb.h"
+
+static SW_STATE_t sw_state = SW_STATE_DETACHED;
+static bool streaming_before_suspend = false;
+static bool resume_on_mount = false;
+static bool awaiting_handshake = false;  // mounted, no input session yet
+static uint8_t handshake_retries = 0;
+static uint32_t state_start_ms = 0;
+static uint32_t resume_us = 0;
+static SW_STATE_STATS_t stats;
+
+static void set_state(SW_STATE_t state) {
+  TRACE(TRACE_EV_SW_STATE, state, sw_state);
+  sw_state = state;
+  state_start_ms = board_millis();
+  g_input_enable = (state == SW_STATE_INPUT || state == SW_STATE_RESUMING);
+  if (state == SW_STATE_INPUT) {
+    awaiting_handshake = false;
+    handshake_retries = 0;
+  }
+}
+
+static void reconnect(void) {
+  stats.reconnect_count++;
+  tud_disconnect();
+  set_state(SW_STATE_RECONNECT);
+}
+
+static void resumed_input(void) {
+  uint32_t elapsed_us = time_us_32() - resume_us;
+
+  stats.last_resume_to_input_us = elapsed_us;
+  if (elapsed_us > stats.max_resume_to_input_us) {
+    stats.max_resume_to_input_us = elapsed_us;
+  }
+#ifdef BOOT_TIMING
+  printf("resume: %lu us to input (resume %lu, reconnect %lu, "
+         "handshake timeout %lu)\n",
+         (unsigned long)elapsed_us, (unsigned long)stats.resume_count,
+         (unsigned long)stats.reconnect_count,
+         (unsigned long)stats.handshake_timeout_count);
+#endif
+}
+
+void sw_state_mount(void) {
+  if (resume_on_mount) {
+    // Restored session: same as a resume, reconnect if the host stays quiet
+    resume_on_mount = false;
+    stats.resume_count++;
+    resume_us = time_us_32();
+    set_state(SW_STATE_RESUMING);
+    return;
+  }
+  awaiting_handshake = true;
+  set_state(SW_STATE_MOUNTED);
+}
+
+void sw_state_umount(void) {
+  if (sw_state != SW_STATE_RECONNECT) {
+    set_state(SW_STATE_DETACHED);
+  }
+  sw_tx_reset();
+}
+
+void sw_state_suspend(void) {
+  streaming_before_suspend =
+      (sw_state == SW_STATE_INPUT || sw_state == SW_STATE_RESUMING);
+  set_state(SW_STATE_SUSPENDED);
+}
+
+void sw_state_resume(void) {
+  if (sw_state != SW_STATE_SUSPENDED) {
+    return;
+  }
+  stats.resume_count++;
+  resume_us = time_us_32();
+
+  if (streaming_before_suspend) {
+    // Same session: resume input without waiting for a new handshake
+    set_state(SW_STATE_RESUMING);
+  } else {
+    set_state(tud_mounted() ? SW_STATE_MOUNTED : SW_STATE_DETACHED);
+  }
+}
+
+void sw_state_host_data(uint8_t cmd, uint8_t sub) {
+  if (cmd == 0x80) {
+    switch (sub) {
+      case 0x01:  // Connection status
+      case 0x02:  // Handshake
+      case 0x03:  // Baudrate
+        // Host (re)started the handshake: stop input until 0x80 0x04
+        set_state(SW_STATE_HANDSHAKE);
+        break;
+
+      case 0x04:  // Only talk over USB HID without timeouts
+        if (sw_state == SW_STATE_RESUMING || resume_us != 0) {
+          resumed_input();
+          resume_us = 0;
+        }
+        set_state(SW_STATE_INPUT);
+        break;
+
+      case 0x05:  // Allow USB timeouts
+        awaiting_handshake = false;
+        set_state(SW_STATE_MOUNTED);
+        break;
+    }
+  } else if (sw_state == SW_STATE_HANDSHAKE) {
+    // Subcommand between the 0x80 steps: handshake is progressing
+    state_start_ms = board_millis();
+  } else if (sw_state == SW_STATE_RESUMING) {
+    // Subcommand / rumble: host accepted the resumed session
+    resumed_input();
+    resume_us = 0;
+    set_state(SW_STATE_INPUT);
+  }
+}
+
+void sw_state_task(void) {
+  uint32_t elapsed_ms = board_millis() - state_start_ms;
+
+  switch (sw_state) {
+    case SW_STATE_RESUMING:
+      if (elapsed_ms >= SW_RESUME_TIMEOUT_MS) {
+        // Host ignores us: force re-enumeration (MAC is kept)
+        reconnect();
+      }
+      break;
+
+    case SW_STATE_MOUNTED:
+    case SW_STATE_HANDSHAKE:
+      if ((sw_state == SW_STATE_HANDSHAKE || awaiting_handshake) &&
+          elapsed_ms >= SW_HANDSHAKE_TIMEOUT_MS &&
+          handshake_retries < SW_HANDSHAKE_RETRIES) {
+        // Host stopped before 0x80 0x04: start over (MAC is kept)
+        handshake_retries++;
+        stats.handshake_timeout_count++;
+        reconnect();
+      }
+      break;
+
+    case SW_STATE_RECONNECT:
+      if (elapsed_ms >= SW_RECONNECT_MS) {
+        set_state(SW_STATE_DETACHED);
+        tud_connect();
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void sw_state_recover(void) { resume_on_mount = true; }
+
+SW_STATE_t sw_state_get(void) { return sw_state; }
+
+const SW_STATE_STATS_t *sw_state_stats(void) { return &stats; }
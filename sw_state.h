@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Host session (handshake) state
+typedef enum {
+  SW_STATE_DETACHED = 0,  // not mounted
+  SW_STATE_MOUNTED,       // mounted, waiting for handshake
+  SW_STATE_HANDSHAKE,     // 0x80 0x01-0x03 exchange in progress
+  SW_STATE_INPUT,         // 0x80 0x04 received, streaming 0x30 input
+  SW_STATE_SUSPENDED,     // bus suspended
+  SW_STATE_RESUMING,      // resumed, streaming while waiting for the host
+  SW_STATE_RECONNECT,     // soft disconnected to force re-enumeration
+} SW_STATE_t;
+
+// Resumed host must talk to us within this time, otherwise reconnect
+#define SW_RESUME_TIMEOUT_MS 1000
+// Time to stay disconnected for forced re-enumeration
+#define SW_RECONNECT_MS 50
+// Handshake stalled (mounted and not started, or no host data partway
+// through): reconnect, at most SW_HANDSHAKE_RETRIES times in a row
+// (a host that never handshakes, e.g. a PC, is then left alone)
+#define SW_HANDSHAKE_TIMEOUT_MS 3000
+#define SW_HANDSHAKE_RETRIES 3
+
+typedef struct {
+  uint32_t resume_count;
+  uint32_t reconnect_count;
+  uint32_t last_resume_to_input_us;
+  uint32_t max_resume_to_input_us;
+  uint32_t handshake_timeout_count;
+} SW_STATE_STATS_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sw_state_mount(void);
+void sw_state_umount(void);
+void sw_state_suspend(void);
+void sw_state_resume(void);
+void sw_state_host_data(uint8_t cmd, uint8_t sub);
+// Session restored after a watchdog reset: stream from the next mount on
+void sw_state_recover(void);
+void sw_state_task(void);
+
+SW_STATE_t sw_state_get(void);
+const SW_STATE_STATS_t *sw_state_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,137 @@
+/*
+    Kernel benchmark, native run (Linux)
+
+    usage: ./bench [-u] [-t percent] [baseline file]
+      -u  write current results as the new baseline
+      -t  allowed slowdown in percent (default BENCH_THRESHOLD_PERCENT)
+    exit status is non-zero when a kernel is slower than its baseline
+
+    The baseline holds times relative to the reference kernel (per mille),
+    so it does not depend on this machine's speed. Each kernel is the best
+    of BENCH_ROUNDS batches in BENCH_PASSES passes; a kernel that looks
+    slower is measured again after a pause (HOST_ATTEMPTS runs, best is
+    kept), and slowdowns below HOST_FLOOR_NS are ignored.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define DEFAULT_BASELINE "baseline.txt"
+#define HOST_FLOOR_NS 5  // scheduler / timer noise on a few ns kernels
+#define HOST_ATTEMPTS 5  // runs when a kernel looks slower
+#define HOST_RETRY_DELAY_US 1000000  // past a burst of load from other work
+
+static uint32_t host_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+static int load_baseline(const char *path, const BENCH_RESULT_t *results,
+                         uint32_t *baseline) {
+  FILE *fp = fopen(path, "r");
+  char name[64];
+  unsigned long value;
+  int i;
+
+  memset(baseline, 0, sizeof(uint32_t) * BENCH_CASE_COUNT);
+  if (fp == NULL) {
+    return -1;
+  }
+  while (fscanf(fp, "%63s %lu", name, &value) == 2) {
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+      if (strcmp(name, results[i].name) == 0) {
+        baseline[i] = value;
+      }
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+static int save_baseline(const char *path, const BENCH_RESULT_t *results) {
+  FILE *fp = fopen(path, "w");
+  int i;
+
+  if (fp == NULL) {
+    perror(path);
+    return -1;
+  }
+  for (i = 0; i < BENCH_CASE_COUNT; i++) {
+    fprintf(fp, "%s %lu\n", results[i].name,
+            (unsigned long)results[i].relative);
+  }
+  fclose(fp);
+  return 0;
+}
+
+static int count_slower(const BENCH_CLOCK_t *clock,
+                        const BENCH_RESULT_t *results, uint32_t reference,
+                        const uint32_t *baseline, int threshold) {
+  int failed = 0;
+  int i;
+
+  for (i = 0; i < BENCH_CASE_COUNT; i++) {
+    if (bench_slower(clock, &results[i], reference, baseline[i], threshold)) {
+      failed++;
+    }
+  }
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  BENCH_CLOCK_t clock = {host_now, 0xffffffff, "ns", HOST_FLOOR_NS};
+  BENCH_RESULT_t results[BENCH_CASE_COUNT];
+  BENCH_RESULT_t retry[BENCH_CASE_COUNT];
+  uint32_t baseline[BENCH_CASE_COUNT];
+  uint32_t reference;
+  uint32_t retry_reference;
+  int attempt;
+  const char *path = DEFAULT_BASELINE;
+  int threshold = BENCH_THRESHOLD_PERCENT;
+  int update = 0;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-u") == 0) {
+      update = 1;
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threshold = atoi(argv[++i]);
+    } else {
+      path = argv[i];
+    }
+  }
+
+  reference = bench_run(&clock, results, true);  // mock bus
+  if (!update && load_baseline(path, results, baseline) != 0) {
+    printf("bench: no baseline (%s), run with -u to record\n", path);
+  }
+
+  // Best of several runs: always for a new baseline, otherwise only while
+  // some kernel looks slower
+  for (attempt = 1; attempt < HOST_ATTEMPTS; attempt++) {
+    if (!update &&
+        count_slower(&clock, results, reference, baseline, threshold) == 0) {
+      break;
+    }
+    usleep(HOST_RETRY_DELAY_US);
+    retry_reference = bench_run(&clock, retry, true);
+    if (retry_reference < reference) reference = retry_reference;
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+      if (retry[i].relative < results[i].relative) results[i] = retry[i];
+    }
+  }
+
+  if (update) {
+    bench_report(&clock, results, reference, NULL, threshold);
+    return save_baseline(path, results) == 0 ? 0 : 1;
+  }
+  return bench_report(&clock, results, reference, baseline, threshold) == 0
+             ? 0
+             : 1;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Host stand-in for TinyUSB bsp/board.h
+
+#include <stdint.h>
+
+void board_init(void);
+uint32_t board_millis(void);
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for hardware/spi.h
+
+#include "pico/stdlib.h"
+
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *const spi0;
+
+#define SPI_CPOL_0 0
+#define SPI_CPOL_1 1
+#define SPI_CPHA_0 0
+#define SPI_CPHA_1 1
+#define SPI_LSB_FIRST 0
+#define SPI_MSB_FIRST 1
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+unsigned int spi_set_baudrate(spi_inst_t *spi, unsigned int baudrate);
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, int cpol,
+                    int cpha, int order);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst,
+                            size_t len);
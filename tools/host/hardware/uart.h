@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in for hardware/uart.h
+// uart0 output goes to stdout; uart1 receives what host_uart_rx() queued
+// and its output is counted in host_uart_tx_count
+
+#include "pico/stdlib.h"
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t *const uart0;
+extern uart_inst_t *const uart1;
+
+unsigned int uart_init(uart_inst_t *uart, unsigned int baudrate);
+bool uart_is_writable(uart_inst_t *uart);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
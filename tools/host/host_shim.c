@@ -0,0 +1,201 @@
+/*
+    Host stand-ins for the Pico SDK / TinyUSB functions used by the
+    converter sources
+*/
+
+#include "host_shim.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "bsp/board.h"
+#include "hardware/spi.h"
+#include "hardware/uart.h"
+#include "pico/stdlib.h"
+#include "settings.h"
+#include "tusb.h"
+
+bool g_input_enable = false;
+uint8_t g_usb_mode = 0;
+// All zero: button layout follows PIN_MODE
+SETTINGS_t g_settings;
+
+bool host_virtual_time = false;
+static uint64_t virtual_ns = 0;
+
+//--------------------------------------------------------------------+
+// GPIO
+//--------------------------------------------------------------------+
+#define HOST_GPIO_COUNT 30
+
+// Inputs idle low: PIN_ACK asserted (pad acks at once), PIN_MODE = Pro-con
+static bool gpio_level[HOST_GPIO_COUNT];
+
+void host_gpio_set(unsigned int gpio, bool value) {
+  if (gpio < HOST_GPIO_COUNT) gpio_level[gpio] = value;
+}
+
+void gpio_init(unsigned int gpio) { (void)gpio; }
+void gpio_set_function(unsigned int gpio, int fn) {
+  (void)gpio;
+  (void)fn;
+}
+void gpio_set_dir(unsigned int gpio, bool out) {
+  (void)gpio;
+  (void)out;
+}
+void gpio_set_pulls(unsigned int gpio, bool up, bool down) {
+  (void)gpio;
+  (void)up;
+  (void)down;
+}
+host_gpio_put_hook_t host_gpio_put_hook = NULL;
+host_gpio_get_hook_t host_gpio_get_hook = NULL;
+
+void gpio_put(unsigned int gpio, bool value) {
+  host_gpio_set(gpio, value);
+  if (host_gpio_put_hook != NULL) host_gpio_put_hook(gpio, value);
+}
+bool gpio_get(unsigned int gpio) {
+  bool level = (gpio < HOST_GPIO_COUNT) ? gpio_level[gpio] : false;
+  if (host_virtual_time) virtual_ns += HOST_GPIO_GET_NS;
+  if (host_gpio_get_hook != NULL) level = host_gpio_get_hook(gpio, level);
+  return level;
+}
+
+//--------------------------------------------------------------------+
+// Time
+//--------------------------------------------------------------------+
+uint64_t time_us_64(void) {
+  struct timespec ts;
+
+  if (host_virtual_time) return virtual_ns / 1000;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+absolute_time_t get_absolute_time(void) { return time_us_64(); }
+absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+  return (int64_t)(to - from);
+}
+void sleep_us(uint64_t us) {
+  if (host_virtual_time) virtual_ns += us * 1000;
+}
+void sleep_ms(uint32_t ms) { sleep_us((uint64_t)ms * 1000); }
+
+void board_init(void) {}
+uint32_t board_millis(void) { return (uint32_t)(time_us_64() / 1000); }
+
+//--------------------------------------------------------------------+
+// SPI / UART
+//--------------------------------------------------------------------+
+static char uart1_inst;
+
+spi_inst_t *const spi0 = NULL;
+uart_inst_t *const uart0 = NULL;
+uart_inst_t *const uart1 = (uart_inst_t *)&uart1_inst;
+
+host_spi_hook_t host_spi_hook = NULL;
+unsigned int host_spi_baudrate = 0;
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate) {
+  (void)spi;
+  host_spi_baudrate = baudrate;
+  return baudrate;
+}
+
+unsigned int spi_set_baudrate(spi_inst_t *spi, unsigned int baudrate) {
+  (void)spi;
+  host_spi_baudrate = baudrate;
+  return baudrate;
+}
+
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, int cpol,
+                    int cpha, int order) {
+  (void)spi;
+  (void)data_bits;
+  (void)cpol;
+  (void)cpha;
+  (void)order;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst,
+                            size_t len) {
+  (void)spi;
+  if (host_virtual_time && host_spi_baudrate > 0) {
+    virtual_ns += (uint64_t)len * 8 * 1000000000 / host_spi_baudrate;
+  }
+  if (host_spi_hook != NULL) {
+    host_spi_hook(src, dst, len);
+  } else {
+    memset(dst, 0xff, len);
+  }
+  return (int)len;
+}
+
+#define HOST_UART_RX_SIZE 4096
+
+static uint8_t uart_rx[HOST_UART_RX_SIZE];
+static size_t uart_rx_head = 0;
+static size_t uart_rx_tail = 0;
+uint32_t host_uart_tx_count = 0;
+
+bool host_uart_rx(const uint8_t *data, size_t len) {
+  size_t i;
+
+  if (HOST_UART_RX_SIZE - (uart_rx_head - uart_rx_tail) < len) return false;
+  for (i = 0; i < len; i++) {
+    uart_rx[uart_rx_head++ % HOST_UART_RX_SIZE] = data[i];
+  }
+  return true;
+}
+
+unsigned int uart_init(uart_inst_t *uart, unsigned int baudrate) {
+  (void)uart;
+  return baudrate;
+}
+
+bool uart_is_writable(uart_inst_t *uart) {
+  (void)uart;
+  return true;
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+  return uart == uart1 && uart_rx_head != uart_rx_tail;
+}
+
+char uart_getc(uart_inst_t *uart) {
+  if (!uart_is_readable(uart)) return 0;
+  return uart_rx[uart_rx_tail++ % HOST_UART_RX_SIZE];
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c) {
+  if (uart == uart1) {
+    host_uart_tx_count++;
+    return;
+  }
+  putchar(c);
+}
+
+//--------------------------------------------------------------------+
+// TinyUSB
+//--------------------------------------------------------------------+
+uint8_t host_hid_report_id = 0;
+uint8_t host_hid_report[64];
+uint32_t host_hid_report_count = 0;
+bool host_hid_ready = true;
+
+bool tud_mounted(void) { return true; }
+bool tud_connect(void) { return true; }
+bool tud_disconnect(void) { return true; }
+bool tud_hid_ready(void) { return host_hid_ready; }
+
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len) {
+  if (len > sizeof(host_hid_report)) len = sizeof(host_hid_report);
+  host_hid_report_id = report_id;
+  memcpy(host_hid_report, report, len);
+  host_hid_report_count++;
+  return true;
+}
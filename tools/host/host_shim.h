@@ -0,0 +1,53 @@
+#pragma once
+
+// Hooks into the host stand-ins
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// GPIO input level seen by gpio_get()
+void host_gpio_set(unsigned int gpio, bool value);
+
+// GPIO hooks for a simulated device (default: NULL)
+// put: called for every gpio_put()
+// get: returns the level seen by gpio_get() (`level`: host_gpio_set() value)
+typedef void (*host_gpio_put_hook_t)(unsigned int gpio, bool value);
+typedef bool (*host_gpio_get_hook_t)(unsigned int gpio, bool level);
+extern host_gpio_put_hook_t host_gpio_put_hook;
+extern host_gpio_get_hook_t host_gpio_get_hook;
+
+// SPI transfer hook: called for every spi_write_read_blocking()
+// (default: no device, MISO reads 0xff)
+typedef void (*host_spi_hook_t)(const uint8_t *src, uint8_t *dst, size_t len);
+extern host_spi_hook_t host_spi_hook;
+
+// Clock set by spi_init() / spi_set_baudrate()
+extern unsigned int host_spi_baudrate;
+
+// UART1 receive: queued bytes are read by uart_is_readable() / uart_getc()
+// (returns false when the queue is full)
+bool host_uart_rx(const uint8_t *data, size_t len);
+// Bytes written to UART1
+extern uint32_t host_uart_tx_count;
+
+// Virtual time (default false: time_us_64() is the host clock)
+// time only advances by bus activity, so timing is exact and repeatable:
+// spi_write_read_blocking() 8 clocks per byte, gpio_get() HOST_GPIO_GET_NS,
+// sleep_us() as requested
+#define HOST_GPIO_GET_NS 250  // one pass of a polling loop on the target
+extern bool host_virtual_time;
+
+// Last report passed to tud_hid_report()
+extern uint8_t host_hid_report_id;
+extern uint8_t host_hid_report[64];
+extern uint32_t host_hid_report_count;
+extern bool host_hid_ready;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+// Host stand-in for pico/stdlib.h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t absolute_time_t;
+
+#define GPIO_FUNC_XIP 0
+#define GPIO_FUNC_SPI 1
+#define GPIO_FUNC_UART 2
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __no_inline_not_in_flash_func(func_name) func_name
+#define __force_inline inline __attribute__((always_inline))
+#define __uninitialized_ram(group) group
+#define tight_loop_contents() \
+  do {                        \
+  } while (0)
+
+void gpio_init(unsigned int gpio);
+void gpio_set_function(unsigned int gpio, int fn);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_set_pulls(unsigned int gpio, bool up, bool down);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_us(uint64_t us);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,200 @@
+/*
+    Byte-level software PSX pad (host shim device)
+*/
+
+#include "psx_pad_model.h"
+
+#include <string.h>
+
+#include "host_shim.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+
+#define PAD_ADDR 0x01
+#define PAD_ID_CONFIG 0xf3
+#define PAD_MARKER 0x5a
+
+#define PAD_CMD_POLL 0x42
+#define PAD_CMD_CONFIG 0x43
+#define PAD_CMD_SET_ANALOG 0x44
+#define PAD_CMD_STATUS 0x45
+#define PAD_CMD_SET_PRESSURE 0x4f
+
+static PSX_PAD_MODEL_t *attached = NULL;
+
+static uint8_t reverse(uint8_t data) {
+  uint8_t result = 0;
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    result = (result << 1) | ((data >> i) & 1);
+  }
+  return result;
+}
+
+static uint8_t current_id(const PSX_PAD_MODEL_t *pad) {
+  if (pad->config_mode) return PAD_ID_CONFIG;
+  if (!pad->analog) return PSX_CTRLID_DIGITAL;
+  if (pad->pressure) return PSX_CTRLID_DUAL_SHOCK2;
+  return PSX_CTRLID_DUAL_ANALOG;
+}
+
+// Fill the reply from byte 2 on, once the command byte is known
+static void start_command(PSX_PAD_MODEL_t *pad, uint8_t command) {
+  uint8_t id = pad->reply[1];
+  bool dualshock = (pad->type != PSX_PAD_MODEL_DIGITAL);
+
+  pad->command = command;
+  pad->reply[2] = PAD_MARKER;
+  memset(&pad->reply[3], 0x00, sizeof(pad->reply) - 3);
+
+  if (id == PAD_ID_CONFIG) {
+    pad->frame_len = 9;
+    if (command == PAD_CMD_STATUS) {
+      static const uint8_t status[] = {0x03, 0x02, 0x00, 0x02, 0x01, 0x00};
+      memcpy(&pad->reply[3], status, sizeof(status));
+      pad->reply[5] = pad->analog;
+      return;
+    }
+    if (command != PAD_CMD_POLL) return;
+  } else if (command != PAD_CMD_POLL &&
+             !(command == PAD_CMD_CONFIG && dualshock)) {
+    pad->frame_len = 2;  // unsupported: no more ACK
+    return;
+  }
+
+  // Poll data (buttons are active low on the bus)
+  pad->reply[3] = ~(pad->buttons & 0xff);
+  pad->reply[4] = ~(pad->buttons >> 8);
+  pad->frame_len = 5;
+  if (id == PSX_CTRLID_DIGITAL) return;
+
+  memcpy(&pad->reply[5], pad->sticks, sizeof(pad->sticks));
+  pad->frame_len = 9;
+  if (id == PSX_CTRLID_DUAL_SHOCK2) {
+    memcpy(&pad->reply[9], pad->pressure_values,
+           sizeof(pad->pressure_values));
+    pad->frame_len = 21;
+  }
+}
+
+// Mode changes take effect when the frame ends
+static void end_command(PSX_PAD_MODEL_t *pad) {
+  if (pad->type == PSX_PAD_MODEL_DIGITAL || pad->index < 4) return;
+
+  switch (pad->command) {
+    case PAD_CMD_CONFIG:
+      pad->config_mode = (pad->args[3] == 0x01);
+      break;
+
+    case PAD_CMD_SET_ANALOG:
+      if (pad->config_mode) {
+        pad->analog = (pad->args[3] == 0x01);
+        if (!pad->analog) pad->pressure = false;
+      }
+      break;
+
+    case PAD_CMD_SET_PRESSURE:
+      if (pad->config_mode && pad->type == PSX_PAD_MODEL_DUALSHOCK2 &&
+          pad->index >= 6) {
+        pad->pressure =
+            pad->analog && (pad->args[3] | pad->args[4] | pad->args[5]);
+      }
+      break;
+  }
+}
+
+static void gpio_put_hook(unsigned int gpio, bool value) {
+  PSX_PAD_MODEL_t *pad = attached;
+
+  if (pad == NULL || gpio != PIN_CS) return;
+
+  if (value == false) {
+    pad->selected = true;
+    pad->index = 0;
+    pad->command = 0;
+    pad->frame_errors = 0;
+    pad->frame_len = 2;
+    pad->reply[0] = 0xff;
+    pad->reply[1] = current_id(pad);
+  } else if (pad->selected) {
+    pad->selected = false;
+    pad->ack_end_us = 0;
+    if (pad->connected) {
+      end_command(pad);
+      pad->frames++;
+    }
+  }
+}
+
+static bool gpio_get_hook(unsigned int gpio, bool level) {
+  PSX_PAD_MODEL_t *pad = attached;
+
+  if (pad == NULL || gpio != PIN_ACK) return level;
+
+  // Open drain, pulled up: low only during the pad's ACK pulse
+  uint64_t now = time_us_64();
+  return !(pad->connected && now >= pad->ack_start_us &&
+           now < pad->ack_end_us);
+}
+
+static void spi_hook(const uint8_t *src, uint8_t *dst, size_t len) {
+  PSX_PAD_MODEL_t *pad = attached;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (pad == NULL || !pad->connected || !pad->selected) {
+      dst[i] = 0xff;
+      continue;
+    }
+
+    uint8_t index = pad->index;
+    uint8_t cmd = reverse(src[i]);
+    uint8_t reply = 0xff;
+
+    if (index < sizeof(pad->args)) pad->args[index] = cmd;
+
+    if (index == 0 && cmd != PAD_ADDR) {
+      pad->frame_len = 0;  // not for us
+    }
+    if (index < pad->frame_len) {
+      reply = pad->reply[index];
+      pad->bytes++;
+      if (pad->error_interval != 0 &&
+          pad->bytes % pad->error_interval == 0) {
+        reply ^= 1 << (pad->errors_injected++ & 7);
+        if (index < 32) pad->frame_errors |= 1u << index;
+      }
+    }
+    if (index == 1 && pad->frame_len != 0) {
+      start_command(pad, cmd);
+    }
+
+    // ACK after every byte but the last
+    if (index + 1 < pad->frame_len) {
+      pad->ack_start_us = time_us_64() + pad->ack_delay_us;
+      pad->ack_end_us = pad->ack_start_us + pad->ack_width_us;
+      pad->acks++;
+    }
+
+    dst[i] = reverse(reply);
+    if (pad->index < 0xff) pad->index++;
+  }
+}
+
+void psx_pad_model_init(PSX_PAD_MODEL_t *pad, PSX_PAD_MODEL_TYPE_t type) {
+  memset(pad, 0, sizeof(*pad));
+  pad->type = type;
+  pad->connected = true;
+  pad->analog = (type != PSX_PAD_MODEL_DIGITAL);
+  memset(pad->sticks, 0x80, sizeof(pad->sticks));
+  pad->ack_delay_us = 10;
+  pad->ack_width_us = 3;
+}
+
+void psx_pad_model_attach(PSX_PAD_MODEL_t *pad) {
+  attached = pad;
+  host_spi_hook = (pad != NULL) ? spi_hook : NULL;
+  host_gpio_put_hook = (pad != NULL) ? gpio_put_hook : NULL;
+  host_gpio_get_hook = (pad != NULL) ? gpio_get_hook : NULL;
+}
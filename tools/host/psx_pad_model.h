@@ -0,0 +1,62 @@
+#pragma once
+
+// Byte-level software PSX pad for the host shim
+// Answers spi_write_read_blocking() / gpio_get(PIN_ACK) like a pad on the
+// bus: frame starts at CS low, ID byte, 0x5A, data bytes, ACK pulse after
+// every byte but the last. Attach with psx_pad_model_attach().
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  PSX_PAD_MODEL_DIGITAL,     // SCPH-1080: 0x41 only
+  PSX_PAD_MODEL_DUALSHOCK,   // SCPH-1200: 0x41 / 0x73, config mode
+  PSX_PAD_MODEL_DUALSHOCK2,  // SCPH-10010: + 0x79 pressure mode
+} PSX_PAD_MODEL_TYPE_t;
+
+typedef struct {
+  // Device (may be changed between polls)
+  PSX_PAD_MODEL_TYPE_t type;
+  bool connected;
+  uint16_t buttons;  // pressed = 1, PSX_BUTTON1_* | PSX_BUTTON2_* << 8
+  uint8_t sticks[4];  // RX RY LX LY
+  uint8_t pressure_values[12];
+  uint32_t ack_delay_us;    // end of byte -> ACK low
+  uint32_t ack_width_us;    // ACK low time
+  uint32_t error_interval;  // flip one bit every N reply bytes, 0 = off
+
+  // Mode (changed by the host through config commands)
+  bool analog;
+  bool pressure;
+  bool config_mode;
+
+  // Frame in progress
+  bool selected;
+  uint8_t index;
+  uint8_t command;
+  uint8_t frame_len;
+  uint8_t reply[21];
+  uint8_t args[21];
+  uint64_t ack_start_us;
+  uint64_t ack_end_us;
+  uint32_t frame_errors;  // reply bytes with a flipped bit (bit = index)
+
+  // Counters
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t acks;
+  uint32_t errors_injected;
+} PSX_PAD_MODEL_t;
+
+// Digital / analog, all released, ACK 10 us after each byte for 3 us
+void psx_pad_model_init(PSX_PAD_MODEL_t *pad, PSX_PAD_MODEL_TYPE_t type);
+// Route the host shim SPI / GPIO hooks to `pad` (NULL: detach)
+void psx_pad_model_attach(PSX_PAD_MODEL_t *pad);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// Host stand-in for tusb.h (device side, HID only)
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  HID_REPORT_TYPE_INVALID = 0,
+  HID_REPORT_TYPE_INPUT,
+  HID_REPORT_TYPE_OUTPUT,
+  HID_REPORT_TYPE_FEATURE
+} hid_report_type_t;
+
+bool tud_mounted(void);
+bool tud_connect(void);
+bool tud_disconnect(void);
+bool tud_hid_ready(void);
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
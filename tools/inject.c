@@ -0,0 +1,198 @@
+/*
+    Input injection sender (Linux)
+
+    Streams a timed input script to an INPUT_INJECT build on UART1 (through
+    a USB-serial adapter) and prints the converter's statistics.
+
+    build: gcc -O2 -o inject inject.c
+    usage: ./inject /dev/ttyUSB0 script.txt [lead_ms]
+
+    script: one frame per line, '#' starts a comment
+      <time_ms> <buttons> <lx> <ly> <rx> <ry>
+      buttons: Switch report bytes 0-2 as hex (byte 0 = low), e.g. 0x000008
+      sticks : 0-4095, 2048 = center
+    frames are sent `lead_ms` (default 20) ahead of their time; the
+    converter's jitter buffer lines them up with its reports
+*/
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../input_inject.h"
+
+#define MAX_FRAMES 100000
+#define DEFAULT_LEAD_MS 20
+
+static INJECT_FRAME_t frames[MAX_FRAMES];
+
+static uint32_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static void pack_stick(uint8_t *out, uint16_t x, uint16_t y) {
+  out[0] = x & 0xff;
+  out[1] = (x >> 8) | ((y & 0x0f) << 4);
+  out[2] = y >> 4;
+}
+
+static int load_script(const char *path) {
+  FILE *fp = fopen(path, "r");
+  char line[256];
+  int count = 0;
+
+  if (fp == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL && count < MAX_FRAMES) {
+    unsigned long time_ms, buttons;
+    unsigned int lx, ly, rx, ry;
+
+    if (sscanf(line, "%lu %lx %u %u %u %u", &time_ms, &buttons, &lx, &ly,
+               &rx, &ry) != 6) {
+      continue;  // comment or blank
+    }
+    frames[count].time_us = time_ms * 1000;
+    frames[count].input[0] = buttons & 0xff;
+    frames[count].input[1] = (buttons >> 8) & 0xff;
+    frames[count].input[2] = (buttons >> 16) & 0xff;
+    pack_stick(&frames[count].input[3], lx & 0xfff, ly & 0xfff);
+    pack_stick(&frames[count].input[6], rx & 0xfff, ry & 0xfff);
+    count++;
+  }
+  fclose(fp);
+  return count;
+}
+
+static int open_serial(const char *path) {
+  struct termios tio;
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B115200);  // INJECT_BAUD_RATE
+  cfsetospeed(&tio, B115200);
+  tcsetattr(fd, TCSANOW, &tio);
+  return fd;
+}
+
+static void send_packet(int fd, uint8_t type, const void *payload,
+                        uint8_t length) {
+  uint8_t packet[5 + 32];
+  uint8_t check = type ^ length;
+  int i;
+
+  packet[0] = INJECT_SYNC0;
+  packet[1] = INJECT_SYNC1;
+  packet[2] = type;
+  packet[3] = length;
+  memcpy(&packet[4], payload, length);
+  for (i = 0; i < length; i++) check ^= packet[4 + i];
+  packet[4 + length] = check;
+
+  if (write(fd, packet, 5 + length) != 5 + length) perror("write");
+}
+
+static void print_stats(const INJECT_STATS_t *stats) {
+  printf("inject: %s, received %lu, played %lu, skipped %lu, late %lu, "
+         "underruns %lu, overflows %lu, bad %lu, overrides %lu, "
+         "drift %ld us, depth %u\n",
+         stats->active ? "active" : "idle", (unsigned long)stats->received,
+         (unsigned long)stats->played, (unsigned long)stats->skipped,
+         (unsigned long)stats->late, (unsigned long)stats->underruns,
+         (unsigned long)stats->overflows, (unsigned long)stats->bad_packets,
+         (unsigned long)stats->overrides, (long)stats->drift_us,
+         stats->depth);
+  fflush(stdout);
+}
+
+// Find stats packets in the bytes from the converter
+static void receive(int fd) {
+  static uint8_t buf[256];
+  static size_t len = 0;
+  const size_t packet_len = 5 + sizeof(INJECT_STATS_t);
+  int n = read(fd, &buf[len], sizeof(buf) - len);
+  size_t pos = 0;
+
+  if (n > 0) len += n;
+
+  while (len - pos >= packet_len) {
+    uint8_t check = 0;
+    size_t i;
+
+    if (buf[pos] != INJECT_SYNC0 || buf[pos + 1] != INJECT_SYNC1 ||
+        buf[pos + 2] != INJECT_PKT_STATS ||
+        buf[pos + 3] != sizeof(INJECT_STATS_t)) {
+      pos++;
+      continue;
+    }
+    for (i = 2; i < packet_len - 1; i++) check ^= buf[pos + i];
+    if (check == buf[pos + packet_len - 1]) {
+      INJECT_STATS_t stats;
+      memcpy(&stats, &buf[pos + 4], sizeof(stats));
+      print_stats(&stats);
+      pos += packet_len;
+    } else {
+      pos++;
+    }
+  }
+  memmove(buf, &buf[pos], len - pos);
+  len -= pos;
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t lead_us = DEFAULT_LEAD_MS * 1000;
+  uint32_t start_us;
+  int count;
+  int next = 0;
+  int fd;
+
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s /dev/ttyUSB0 script.txt [lead_ms]\n",
+            argv[0]);
+    return 1;
+  }
+  if (argc > 3) lead_us = atoi(argv[3]) * 1000;
+
+  count = load_script(argv[2]);
+  if (count <= 0) {
+    fprintf(stderr, "%s: no frames\n", argv[2]);
+    return 1;
+  }
+  fd = open_serial(argv[1]);
+  if (fd < 0) return 1;
+
+  // Script time 0 = now
+  start_us = now_us();
+  while (next < count) {
+    uint32_t elapsed = now_us() - start_us;
+
+    while (next < count && frames[next].time_us <= elapsed + lead_us) {
+      send_packet(fd, INJECT_PKT_FRAME, &frames[next], sizeof(frames[0]));
+      next++;
+    }
+    receive(fd);
+    usleep(1000);
+  }
+
+  // Let the buffered frames play out, then hand back to the pad
+  usleep(lead_us + INJECT_START_DELAY_US);
+  send_packet(fd, INJECT_PKT_STOP, NULL, 0);
+  usleep(INJECT_STATS_INTERVAL_US);
+  receive(fd);
+
+  close(fd);
+  return 0;
+}
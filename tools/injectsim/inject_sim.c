@@ -0,0 +1,340 @@
+/*
+    PC input injection scenarios against the jitter buffer, native run (Linux)
+
+    Runs input_inject.c on the host shim: a simulated PC sends frames
+    (tools/inject timing: FRAME_US apart, LEAD_US ahead of their time) into
+    UART1 with a delivery model (random delay, bursts, a stall, PC clock
+    error), the main loop calls input_inject_task() and input_inject_apply()
+    at the Switch report interval. Time is virtual, so runs are repeatable.
+
+    usage: ./inject_sim
+    exit status is non-zero when a scenario does not behave as expected
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_shim.h"
+#include "input_inject.h"
+#include "pico/stdlib.h"
+#include "psx_decoder.h"
+#include "sw_controller.h"
+
+#define FRAME_US 16000  // script frame period
+#define LEAD_US 20000   // tools/inject default
+#define REPORT_US (SW_REPORT_INTERVAL_MS * 1000)
+#define STEP_US 100     // main loop pass
+#define DRAIN_US 100000  // after the last frame, before INJECT_PKT_STOP
+#define MAX_FRAMES 4096
+
+typedef struct {
+  const char *name;
+  uint32_t duration_us;  // frames sent
+  int32_t ppm;           // PC clock error
+  uint32_t jitter_us;    // random delivery delay 0..jitter_us
+  uint32_t burst_us;     // delivered in bursts (USB serial latency timer)
+  uint32_t stall_at_us;  // delivery stalls once (0: none)
+  uint32_t stall_us;
+  uint32_t pad_from_us;  // pad in use (pad_to_us 0: never)
+  uint32_t pad_to_us;
+  uint32_t tail_us;      // last part of the stream, counted separately
+  bool no_stop;          // stream just ends (timeout) instead of STOP
+} STREAM_t;
+
+typedef struct {
+  INJECT_STATS_t stream;  // counters until the last frame was shown
+  INJECT_STATS_t total;  // counters over the run
+  INJECT_STATS_t tail;   // .. since tail_us before the end of sending
+  uint32_t tail_elapsed_us;
+  uint32_t frames;
+  uint32_t shown;        // distinct frames seen in reports
+  uint32_t pad_reports;  // reports while the pad was in use
+  uint32_t pad_replaced;  // .. replaced anyway
+  bool in_order;
+  bool last_applied;     // last report was replaced
+  bool active;           // still active at the end
+} RUN_t;
+
+static int failures = 0;
+static uint32_t rng = 12345;
+
+static uint32_t random_us(uint32_t range) {
+  rng = rng * 1103515245 + 12345;
+  return range ? (rng >> 8) % range : 0;
+}
+
+static void send_packet(uint8_t type, const void *payload, uint8_t length) {
+  uint8_t packet[5 + 32];
+  uint8_t check = type ^ length;
+  int i;
+
+  packet[0] = INJECT_SYNC0;
+  packet[1] = INJECT_SYNC1;
+  packet[2] = type;
+  packet[3] = length;
+  memcpy(&packet[4], payload, length);
+  for (i = 0; i < length; i++) check ^= packet[4 + i];
+  packet[4 + length] = check;
+  host_uart_rx(packet, 5 + length);
+}
+
+// counters since `from`
+static void stats_diff(INJECT_STATS_t *out, const INJECT_STATS_t *from) {
+  const INJECT_STATS_t *now = input_inject_stats();
+
+  *out = *now;
+  out->received -= from->received;
+  out->played -= from->played;
+  out->skipped -= from->skipped;
+  out->late -= from->late;
+  out->underruns -= from->underruns;
+  out->overflows -= from->overflows;
+  out->bad_packets -= from->bad_packets;
+  out->overrides -= from->overrides;
+  out->drift_us -= from->drift_us;
+}
+
+// Local time when frame `k` arrives (relative to the stream start)
+static uint32_t delivery_us(const STREAM_t *s, uint32_t k) {
+  // PC clock runs (1 + ppm) against ours and starts LEAD_US early
+  uint32_t t = (uint64_t)k * FRAME_US * 1000000 / (1000000 + s->ppm);
+
+  t += random_us(s->jitter_us);
+  if (s->burst_us) t += s->burst_us - t % s->burst_us;
+  if (s->stall_us && t >= s->stall_at_us && t < s->stall_at_us + s->stall_us) {
+    t = s->stall_at_us + s->stall_us;
+  }
+  return t;
+}
+
+static void run_stream(const STREAM_t *s, RUN_t *run) {
+  static bool seen[MAX_FRAMES];
+  INJECT_STATS_t start, tail_start;
+  INJECT_FRAME_t frame;
+  uint8_t sw_input[SW_INPUT_SIZE];
+  uint32_t frames = s->duration_us / FRAME_US;
+  uint32_t end_us = s->duration_us + (s->no_stop ? 2 * INJECT_TIMEOUT_US
+                                                 : DRAIN_US);
+  uint32_t tail_from = s->duration_us - s->tail_us;
+  uint32_t next = 0, next_due = 0, last_due = 0;
+  uint32_t report_us = 0;
+  uint32_t t;
+  int last_index = -1;
+  bool tail_taken = false;
+
+  if (frames > MAX_FRAMES) frames = MAX_FRAMES;
+  memset(run, 0, sizeof(*run));
+  memset(seen, 0, sizeof(seen));
+  run->frames = frames;
+  run->in_order = true;
+  start = *input_inject_stats();
+
+  next_due = delivery_us(s, 0);
+  for (t = 0; t < end_us; t += STEP_US) {
+    // UART delivery keeps the order
+    while (next < frames && next_due <= t) {
+      frame.time_us = 1000000 + next * FRAME_US;
+      memset(frame.input, 0, sizeof(frame.input));
+      frame.input[0] = next;
+      frame.input[1] = next >> 8;
+      send_packet(INJECT_PKT_FRAME, &frame, sizeof(frame));
+      last_due = next_due;
+      if (++next < frames) {
+        next_due = delivery_us(s, next);
+        if (next_due < last_due) next_due = last_due;
+      }
+    }
+    if (!tail_taken && t >= tail_from) {
+      tail_start = *input_inject_stats();
+      tail_taken = true;
+    }
+
+    input_inject_task();
+
+    if (t >= report_us) {
+      bool pad = t >= s->pad_from_us && t < s->pad_to_us;
+
+      report_us += REPORT_US;
+      memset(sw_input, 0xff, sizeof(sw_input));
+      run->last_applied = input_inject_apply(sw_input, pad);
+      if (pad) run->pad_reports++;
+      if (run->last_applied) {
+        int index = sw_input[0] | (sw_input[1] << 8);
+
+        if (pad) run->pad_replaced++;
+        if (index < last_index || index >= (int)frames) run->in_order = false;
+        if (index >= 0 && index < (int)frames && !seen[index]) {
+          seen[index] = true;
+          run->shown++;
+          if (index == (int)frames - 1) {
+            stats_diff(&run->stream, &start);
+            stats_diff(&run->tail, &tail_start);
+            run->tail_elapsed_us = t - tail_from;
+          }
+        }
+        last_index = index;
+      }
+    }
+    sleep_us(STEP_US);
+  }
+  if (!s->no_stop) {
+    send_packet(INJECT_PKT_STOP, NULL, 0);
+    input_inject_task();
+  }
+  stats_diff(&run->total, &start);
+  run->active = input_inject_stats()->active;
+}
+
+// `st`: run->stream, or run->total when the end of the run matters
+static void report(const STREAM_t *s, const INJECT_STATS_t *st, bool ok,
+                   const char *note) {
+  printf("inject: %-12s %s  rx %4lu played %4lu skipped %2lu late %2lu "
+         "underruns %2lu drift %6ld us",
+         s->name, ok ? "ok  " : "FAIL", (unsigned long)st->received,
+         (unsigned long)st->played, (unsigned long)st->skipped,
+         (unsigned long)st->late, (unsigned long)st->underruns,
+         (long)st->drift_us);
+  if (note != NULL) printf("  (%s)", note);
+  printf("\n");
+  if (!ok) failures++;
+}
+
+// No drops and no overruns: every counter a clean stream should keep at 0
+static bool clean(const INJECT_STATS_t *st) {
+  return st->late == 0 && st->underruns == 0 && st->skipped == 0 &&
+         st->overflows == 0 && st->bad_packets == 0;
+}
+
+static void scenario_steady(void) {
+  STREAM_t s = {.name = "steady", .duration_us = 10000000, .jitter_us = 2000};
+  RUN_t run;
+
+  run_stream(&s, &run);
+  report(&s, &run.stream,
+         clean(&run.stream) && run.total.received == run.frames &&
+             run.shown == run.frames && run.in_order && !run.active,
+         "every frame shown once, in order");
+}
+
+static void scenario_bursty(void) {
+  STREAM_t s = {.name = "bursty", .duration_us = 10000000, .jitter_us = 2000,
+                .burst_us = 24000};
+  RUN_t run;
+
+  run_stream(&s, &run);
+  report(&s, &run.stream,
+         clean(&run.stream) && run.shown == run.frames && run.in_order,
+         "24 ms bursts absorbed by the buffer");
+}
+
+static void scenario_late(void) {
+  STREAM_t s = {.name = "late", .duration_us = 10000000, .jitter_us = 2000,
+                .stall_at_us = 5000000, .stall_us = 80000,
+                .tail_us = 3000000};
+  RUN_t run;
+
+  run_stream(&s, &run);
+  // Stalled frames arrive late and are due together: the newest is shown
+  report(&s, &run.stream,
+         run.total.late > 0 && run.total.skipped > 0 &&
+             run.total.underruns > 0 && run.total.overflows == 0 &&
+             run.shown + run.total.skipped == run.frames && run.in_order &&
+             clean(&run.tail),
+         "80 ms stall, clean afterwards");
+}
+
+static void scenario_drift(const char *name, int32_t ppm) {
+  STREAM_t s = {.name = name, .duration_us = 40000000, .ppm = ppm,
+                .jitter_us = 2000, .tail_us = 10000000};
+  int32_t expect;
+  RUN_t run;
+  char note[64];
+
+  run_stream(&s, &run);
+  // Offset moves by the clock error once converged
+  expect = (int64_t)-ppm * run.tail_elapsed_us / 1000000;
+  snprintf(note, sizeof(note), "last 10 s: %ld us, expected %ld us",
+           (long)run.tail.drift_us, (long)expect);
+  report(&s, &run.stream,
+         clean(&run.stream) && run.shown == run.frames && run.in_order &&
+             clean(&run.tail) &&
+             labs((long)(run.tail.drift_us - expect)) <= 1500,
+         note);
+}
+
+static void scenario_timeout(void) {
+  STREAM_t s = {.name = "timeout", .duration_us = 2000000, .jitter_us = 2000,
+                .no_stop = true};
+  RUN_t run;
+
+  run_stream(&s, &run);
+  // Last frame repeated until INJECT_TIMEOUT_US, then back to the pad
+  report(&s, &run.total,
+         run.total.underruns > 0 && run.total.late == 0 && !run.active &&
+             !run.last_applied && run.shown == run.frames,
+         "stream ends without STOP");
+}
+
+static void scenario_pad(void) {
+  STREAM_t s = {.name = "pad", .duration_us = 5000000, .jitter_us = 2000,
+                .pad_from_us = 2000000, .pad_to_us = 3000000};
+  RUN_t run;
+
+  run_stream(&s, &run);
+  report(&s, &run.stream,
+         run.pad_reports > 0 && run.total.overrides == run.pad_reports &&
+             run.pad_replaced == 0 && clean(&run.stream) && run.in_order,
+         "pad wins for 1 s, stream continues");
+}
+
+static void scenario_pad_active(void) {
+  // psx_recv: 0x5A, buttons[2], RX RY LX LY
+  static const struct {
+    uint8_t psx[7];
+    bool sticks;
+    uint8_t deadzone;
+    bool expect;
+  } cases[] = {
+      {{0x5a, 0x00, 0x00, 0x80, 0x80, 0x80, 0x80}, true, 0, false},
+      {{0x5a, 0x00, 0x40, 0x80, 0x80, 0x80, 0x80}, false, 0, true},
+      {{0x5a, 0x00, 0x00, 0x80, 0x80, 0x80 + INJECT_PAD_STICK_MIN, 0x80},
+       true, 0, false},
+      {{0x5a, 0x00, 0x00, 0x80, 0x80, 0x80 + INJECT_PAD_STICK_MIN + 1, 0x80},
+       true, 0, true},
+      {{0x5a, 0x00, 0x00, 0x80 - INJECT_PAD_STICK_MIN - 1, 0x80, 0x80, 0x80},
+       true, 0, true},
+      {{0x5a, 0x00, 0x00, 0x80, 0x80, 0x80, 0xff}, false, 0, false},
+      {{0x5a, 0x00, 0x00, 0x80, 0x80 + 40, 0x80, 0x80}, true, 40, false},
+      {{0x5a, 0x00, 0x00, 0x80, 0x80 + 41, 0x80, 0x80}, true, 40, true},
+  };
+  unsigned int i, wrong = 0;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    if (input_inject_pad_active(cases[i].psx, cases[i].sticks,
+                                cases[i].deadzone) != cases[i].expect) {
+      printf("inject: pad_active case %u wrong\n", i);
+      wrong++;
+    }
+  }
+  printf("inject: %-12s %s  %u cases\n", "pad_active", wrong ? "FAIL" : "ok  ",
+         (unsigned int)(sizeof(cases) / sizeof(cases[0])));
+  if (wrong) failures++;
+}
+
+int main(void) {
+  host_virtual_time = true;
+  input_inject_init();
+
+  scenario_pad_active();
+  scenario_steady();
+  scenario_bursty();
+  scenario_late();
+  scenario_drift("drift +1000", 1000);
+  scenario_drift("drift -1000", -1000);
+  scenario_timeout();
+  scenario_pad();
+
+  if (failures) printf("%d scenario(s) failed\n", failures);
+  return failures ? 1 : 0;
+}
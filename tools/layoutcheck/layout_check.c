@@ -0,0 +1,185 @@
+/*
+    Generated button layouts against the hand-written mapping (Linux)
+
+    Runs the digital / analog decoders from psx_decoder.c over every PSX
+    button combination and a sweep of stick values, and compares them with
+    the mapping code they replaced (kept below as the reference).
+    Built three times: runtime layout selection, BUTTON_LAYOUT_PROCON and
+    BUTTON_LAYOUT_TAIKO (fixed builds must ignore settings and MODE pin).
+
+    usage: ./layout_check
+    exit status is non-zero on any mismatch
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "psx_decoder.h"
+#include "settings.h"
+#include "sw_controller.h"
+
+#define IS_BUTTON(button_val, button_const) \
+  (((button_val) & (button_const)) / (button_const))
+
+#define TIMING_CALLS 1000000
+
+// Pre-table mapping (psx_decoder.c before button_layout.h)
+static void reference_map(const uint8_t *psx_recv, uint8_t *sw_input,
+                          bool joy_mode, bool analog) {
+  uint8_t psx_button1 = psx_recv[1];
+  uint8_t psx_button2 = psx_recv[2];
+
+  if (joy_mode == false) {
+    sw_input[0] =
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_A) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_CROSS) << SW_REP0_BITPOS_B) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_TRIANGLE) << SW_REP0_BITPOS_X) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_RECT) << SW_REP0_BITPOS_Y) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_R2) << SW_REP0_BITPOS_ZR) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_R);
+
+    sw_input[1] =
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_SELECT) << SW_REP1_BITPOS_HOME) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP1_BITPOS_PLUS) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_L3) << SW_REP1_BITPOS_THUMBL) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_R3) << SW_REP1_BITPOS_THUMBR);
+
+    sw_input[2] =
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_DOWN) << SW_REP2_BITPOS_DOWN) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_UP) << SW_REP2_BITPOS_UP) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_RIGHT) << SW_REP2_BITPOS_RIGHT) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_LEFT) << SW_REP2_BITPOS_LEFT) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_L1) << SW_REP2_BITPOS_L) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_L2) << SW_REP2_BITPOS_ZL);
+  } else {
+    sw_input[0] =
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_CIRCLE) << SW_REP0_BITPOS_B) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_R1) << SW_REP0_BITPOS_A);
+
+    sw_input[1] =
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_SELECT) << SW_REP1_BITPOS_HOME);
+
+    sw_input[2] =
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_START) << SW_REP2_BITPOS_DOWN) |
+        (IS_BUTTON(psx_button1, PSX_BUTTON1_LEFT) << SW_REP2_BITPOS_RIGHT) |
+        (IS_BUTTON(psx_button2, PSX_BUTTON2_L1) << SW_REP2_BITPOS_LEFT);
+  }
+
+  if (!analog) {
+    // Digital pad: both sticks centered (0x7f0)
+    const uint8_t center[] = {0xf0, 0x07, 0x7f, 0xf0, 0x07, 0x7f};
+    memcpy(sw_input + 3, center, sizeof(center));
+    return;
+  }
+  sw_input[3] = (psx_recv[5] << 4) & 0xff;
+  sw_input[4] = psx_recv[5] >> 4;
+  sw_input[5] = ~psx_recv[6];
+  sw_input[6] = (psx_recv[3] << 4) & 0xff;
+  sw_input[7] = psx_recv[3] >> 4;
+  sw_input[8] = ~psx_recv[4];
+}
+
+static void fill_psx(uint8_t *psx_recv, uint32_t i) {
+  psx_recv[0] = 0x5a;
+  psx_recv[1] = i;
+  psx_recv[2] = i >> 8;
+  psx_recv[3] = i * 37;
+  psx_recv[4] = i * 59 + 1;
+  psx_recv[5] = i * 101 + 2;
+  psx_recv[6] = i * 151 + 3;
+}
+
+// Every button combination through both decoders; false on mismatch
+static bool check(const char *name, bool joy_mode) {
+  static const uint8_t ids[] = {PSX_CTRLID_DIGITAL, PSX_CTRLID_DUAL_ANALOG};
+  uint8_t psx_recv[22];
+  uint8_t expect[SW_INPUT_SIZE];
+  uint8_t actual[SW_INPUT_SIZE];
+  uint32_t i;
+  int k;
+
+  for (k = 0; k < 2; k++) {
+    const PSX_DECODER_t *decoder = psx_find_decoder(ids[k]);
+
+    for (i = 0; i < 0x10000; i++) {
+      fill_psx(psx_recv, i);
+      reference_map(psx_recv, expect, joy_mode, k == 1);
+      decoder->map(psx_recv, actual);
+      if (memcmp(expect, actual, SW_INPUT_SIZE) != 0) {
+        printf("layout: %-22s FAIL  id %02x buttons %04x\n", name, ids[k],
+               (unsigned)i);
+        return false;
+      }
+    }
+  }
+  printf("layout: %-22s ok\n", name);
+  return true;
+}
+
+static double ns_per_call(void (*func)(const uint8_t *, uint8_t *)) {
+  uint8_t psx_recv[22];
+  uint8_t sw_input[SW_INPUT_SIZE];
+  struct timespec t0, t1;
+  uint32_t i;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < TIMING_CALLS; i++) {
+    fill_psx(psx_recv, i);
+    func(psx_recv, sw_input);
+    __asm__ volatile("" : : "r"(sw_input) : "memory");
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+         TIMING_CALLS;
+}
+
+static void reference_analog(const uint8_t *psx_recv, uint8_t *sw_input) {
+  reference_map(psx_recv, sw_input, gpio_get(PIN_MODE), true);
+}
+
+int main(void) {
+  int failures = 0;
+
+  g_settings.button_layout = SETTINGS_LAYOUT_MODE_PIN;
+
+#if defined(BUTTON_LAYOUT_PROCON) || defined(BUTTON_LAYOUT_TAIKO)
+#ifdef BUTTON_LAYOUT_TAIKO
+  const bool fixed = true;
+  printf("layout: fixed TAIKO build\n");
+#else
+  const bool fixed = false;
+  printf("layout: fixed PROCON build\n");
+#endif
+  // Neither the MODE pin nor the settings may change a fixed layout
+  gpio_put(PIN_MODE, 0);
+  failures += !check("fixed, MODE pin low", fixed);
+  gpio_put(PIN_MODE, 1);
+  failures += !check("fixed, MODE pin high", fixed);
+  g_settings.button_layout = SETTINGS_LAYOUT_PROCON;
+  failures += !check("fixed, settings procon", fixed);
+  g_settings.button_layout = SETTINGS_LAYOUT_TAIKO;
+  failures += !check("fixed, settings taiko", fixed);
+  g_settings.button_layout = SETTINGS_LAYOUT_MODE_PIN;
+  gpio_put(PIN_MODE, fixed);
+#else
+  printf("layout: runtime selection build\n");
+  gpio_put(PIN_MODE, 0);
+  failures += !check("MODE pin low", false);
+  gpio_put(PIN_MODE, 1);
+  failures += !check("MODE pin high", true);
+  g_settings.button_layout = SETTINGS_LAYOUT_PROCON;
+  failures += !check("settings procon", false);
+  g_settings.button_layout = SETTINGS_LAYOUT_TAIKO;
+  failures += !check("settings taiko", true);
+  g_settings.button_layout = SETTINGS_LAYOUT_MODE_PIN;
+#endif
+
+  printf("layout: analog map %.1f ns, reference %.1f ns\n",
+         ns_per_call(psx_find_decoder(PSX_CTRLID_DUAL_ANALOG)->map),
+         ns_per_call(reference_analog));
+  printf("layout: %d failure(s)\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,335 @@
+/*
+    PSX bus scenarios against the software pad, native run (Linux)
+
+    Runs comm_psx_pad() / get_psx_pad_data() / psx_enable_pressure() from
+    psx_controller.c on the host shim with tools/host/psx_pad_model.c on
+    the other end of the bus. The host shim runs on virtual time (SPI clock,
+    ACK polling loop), so poll durations and ACK timeouts are repeatable.
+
+    usage: ./pad_sim [-k kHz] [-n polls]
+    exit status is non-zero when a scenario does not behave as expected
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hardware/spi.h"
+#include "host_shim.h"
+#include "pico/stdlib.h"
+#include "psx_controller.h"
+#include "psx_pad_model.h"
+
+#define DEFAULT_POLLS 200
+
+static PSX_PAD_MODEL_t pad;
+static int polls = DEFAULT_POLLS;
+static int failures = 0;
+
+typedef struct {
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t total_us;
+  uint32_t count;
+  uint32_t failed;
+} POLL_STATS_t;
+
+static bool poll(uint8_t *psx_recv, uint8_t *pad_id, POLL_STATS_t *stats) {
+  uint32_t t0 = time_us_32();
+  bool result = get_psx_pad_data(psx_recv, pad_id);
+  uint32_t elapsed = time_us_32() - t0;
+
+  if (stats->count == 0 || elapsed < stats->min_us) stats->min_us = elapsed;
+  if (elapsed > stats->max_us) stats->max_us = elapsed;
+  stats->total_us += elapsed;
+  stats->count++;
+  if (!result) stats->failed++;
+  return result;
+}
+
+static void report(const char *name, bool ok, const POLL_STATS_t *stats,
+                   const char *note) {
+  printf("pad: %-18s %s", name, ok ? "ok  " : "FAIL");
+  if (stats != NULL && stats->count > 0) {
+    printf("  poll min %4lu us avg %4lu us max %4lu us, %lu/%lu failed",
+           (unsigned long)stats->min_us,
+           (unsigned long)(stats->total_us / stats->count),
+           (unsigned long)stats->max_us, (unsigned long)stats->failed,
+           (unsigned long)stats->count);
+  }
+  if (note != NULL) printf("  (%s)", note);
+  printf("\n");
+  if (!ok) failures++;
+}
+
+// Poll `polls` times, every poll must succeed with `id` and `expect` data
+// (except the first one when the ID changed: it only confirms the new ID)
+static void run_polls(const char *name, uint8_t id, const uint8_t *expect,
+                      int len) {
+  POLL_STATS_t stats;
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  bool ok = true;
+  int i;
+
+  memset(&stats, 0, sizeof(stats));
+  for (i = 0; i < polls; i++) {
+    if (!poll(psx_recv, &pad_id, &stats)) {
+      if (i != 0 || pad_id != PSX_CTRLID_INVALID) ok = false;
+    } else if (pad_id != id || memcmp(psx_recv + 1, expect, len) != 0) {
+      ok = false;
+    }
+  }
+  report(name, ok, &stats, NULL);
+}
+
+static void scenario_digital(void) {
+  const uint8_t expect[] = {PSX_BUTTON1_START, PSX_BUTTON2_CIRCLE};
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DIGITAL);
+  pad.buttons = PSX_BUTTON1_START | (PSX_BUTTON2_CIRCLE << 8);
+  run_polls("digital", PSX_CTRLID_DIGITAL, expect, sizeof(expect));
+}
+
+static void scenario_analog(void) {
+  const uint8_t expect[] = {PSX_BUTTON1_UP, PSX_BUTTON2_L1, 0x00, 0x40,
+                            0xc0, 0xff};
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  pad.buttons = PSX_BUTTON1_UP | (PSX_BUTTON2_L1 << 8);
+  memcpy(pad.sticks, expect + 2, sizeof(pad.sticks));
+  run_polls("dualshock analog", PSX_CTRLID_DUAL_ANALOG, expect,
+            sizeof(expect));
+}
+
+static void scenario_pressure(void) {
+  uint8_t expect[2 + 4 + 12];
+  int i;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK2);
+  pad.buttons = PSX_BUTTON2_CROSS << 8;
+  for (i = 0; i < 12; i++) pad.pressure_values[i] = i * 20;
+
+  expect[0] = 0;
+  expect[1] = PSX_BUTTON2_CROSS;
+  memcpy(expect + 2, pad.sticks, sizeof(pad.sticks));
+  memcpy(expect + 6, pad.pressure_values, sizeof(pad.pressure_values));
+
+  if (!psx_enable_pressure() || !pad.pressure || pad.config_mode) {
+    report("ds2 pressure", false, NULL, "config sequence");
+    return;
+  }
+  run_polls("ds2 pressure", PSX_CTRLID_DUAL_SHOCK2, expect, sizeof(expect));
+}
+
+// PS1 DualShock ignores the pressure command but must leave config mode
+static void scenario_ds1_pressure(void) {
+  const uint8_t expect[] = {0, 0, 0x80, 0x80, 0x80, 0x80};
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  psx_enable_pressure();
+  if (pad.pressure || pad.config_mode) {
+    report("ds1 pressure", false, NULL, "mode");
+    return;
+  }
+  run_polls("ds1 pressure", PSX_CTRLID_DUAL_ANALOG, expect, sizeof(expect));
+}
+
+static void scenario_disconnect(void) {
+  POLL_STATS_t stats;
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  bool ok = true;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  memset(&stats, 0, sizeof(stats));
+
+  pad.connected = false;
+  if (poll(psx_recv, &pad_id, &stats) || pad_id != PSX_CTRLID_INVALID) {
+    ok = false;
+  }
+  pad.connected = true;
+  if (!poll(psx_recv, &pad_id, &stats) || pad_id != PSX_CTRLID_DUAL_ANALOG) {
+    ok = false;
+  }
+  report("disconnect", ok, &stats, "1 poll unplugged, 1 poll replugged");
+}
+
+// ACK later than ACK_TIMEOUT_US must fail, just inside must pass
+static void scenario_ack_timing(void) {
+  POLL_STATS_t stats;
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  bool ok;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  memset(&stats, 0, sizeof(stats));
+  pad.ack_delay_us = 80;
+  ok = poll(psx_recv, &pad_id, &stats);
+  report("ack late (80 us)", ok, &stats, NULL);
+
+  memset(&stats, 0, sizeof(stats));
+  pad.ack_delay_us = 150;
+  ok = !poll(psx_recv, &pad_id, &stats) && pad_id == PSX_CTRLID_INVALID;
+  report("ack missing (150)", ok, &stats, "timeout expected");
+}
+
+// Mode change (ANALOG button): the new ID is taken on the second poll
+static void scenario_id_change(void) {
+  POLL_STATS_t stats;
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  bool ok = true;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  memset(&stats, 0, sizeof(stats));
+  poll(psx_recv, &pad_id, &stats);
+  poll(psx_recv, &pad_id, &stats);
+
+  pad.analog = false;
+  if (poll(psx_recv, &pad_id, &stats) || pad_id != PSX_CTRLID_INVALID) {
+    ok = false;
+  }
+  if (!poll(psx_recv, &pad_id, &stats) || pad_id != PSX_CTRLID_DIGITAL) {
+    ok = false;
+  }
+  report("id change", ok, &stats, "analog -> digital");
+}
+
+// There is no checksum on the bus: a corrupted header (ID byte, 0x5A) must
+// fail the poll; flipped data bits pass through and are only counted
+static void scenario_bit_errors(void) {
+  POLL_STATS_t stats;
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  char note[80];
+  bool ok = true;
+  int header_errors = 0;
+  int corrupt = 0;
+  int i;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  pad.error_interval = 37;
+  memset(&stats, 0, sizeof(stats));
+  // Same device: ID already confirmed
+  poll(psx_recv, &pad_id, &stats);
+  memset(&stats, 0, sizeof(stats));
+
+  for (i = 0; i < polls; i++) {
+    bool result = poll(psx_recv, &pad_id, &stats);
+    bool header_bad = (pad.frame_errors & 0x6) != 0;  // byte 1: ID, 2: 0x5A
+
+    if (header_bad) header_errors++;
+    if (result && (header_bad || pad_id != PSX_CTRLID_DUAL_ANALOG ||
+                   psx_recv[0] != PSX_DATA_START)) {
+      ok = false;
+    }
+    if (result &&
+        (psx_recv[1] != 0 || psx_recv[2] != 0 || psx_recv[3] != 0x80 ||
+         psx_recv[4] != 0x80 || psx_recv[5] != 0x80 ||
+         psx_recv[6] != 0x80)) {
+      corrupt++;
+    }
+  }
+  // The error interval must have hit the header at least once
+  if (header_errors == 0) ok = false;
+  snprintf(note, sizeof(note),
+           "%lu bits flipped, %d bad headers, %d polls with bad data",
+           (unsigned long)pad.errors_injected, header_errors, corrupt);
+  report("bit errors", ok, &stats, note);
+}
+
+// Report input: a failed poll (bit error, new ID, unplugged) repeats the last
+// good one, the pad only counts as gone after PSX_HOLD_POLLS failures
+static void scenario_input_hold(void) {
+  uint8_t psx_recv[22];
+  uint8_t pad_id;
+  char note[80];
+  bool ok = true;
+  int held = 0;
+  int i;
+
+  psx_pad_model_init(&pad, PSX_PAD_MODEL_DUALSHOCK);
+  pad.buttons = PSX_BUTTON2_CROSS << 8;
+  get_psx_pad_input(psx_recv, &pad_id);
+  if (!get_psx_pad_input(psx_recv, &pad_id) ||
+      pad_id != PSX_CTRLID_DUAL_ANALOG) {
+    ok = false;
+  }
+
+  // Bit errors never release the pad
+  pad.error_interval = 37;
+  for (i = 0; i < polls; i++) {
+    if (!get_psx_pad_input(psx_recv, &pad_id)) held++;
+    if (pad_id != PSX_CTRLID_DUAL_ANALOG) ok = false;
+  }
+  if (held == 0) ok = false;
+  pad.error_interval = 0;
+
+  // ANALOG button: old ID and input once, then the new ID
+  pad.analog = false;
+  if (get_psx_pad_input(psx_recv, &pad_id) ||
+      pad_id != PSX_CTRLID_DUAL_ANALOG ||
+      psx_recv[2] != PSX_BUTTON2_CROSS) {
+    ok = false;
+  }
+  if (!get_psx_pad_input(psx_recv, &pad_id) ||
+      pad_id != PSX_CTRLID_DIGITAL || psx_recv[2] != PSX_BUTTON2_CROSS) {
+    ok = false;
+  }
+
+  // Unplugged
+  pad.connected = false;
+  for (i = 0; i < PSX_HOLD_POLLS; i++) {
+    if (get_psx_pad_input(psx_recv, &pad_id) ||
+        pad_id != PSX_CTRLID_DIGITAL || psx_recv[2] != PSX_BUTTON2_CROSS) {
+      ok = false;
+    }
+  }
+  if (get_psx_pad_input(psx_recv, &pad_id) ||
+      pad_id != PSX_CTRLID_INVALID) {
+    ok = false;
+  }
+
+  snprintf(note, sizeof(note), "%d/%d polls held under bit errors", held,
+           polls);
+  report("input hold", ok, NULL, note);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int khz = SPI_SPEED_KHZ;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "k:n:")) != -1) {
+    switch (opt) {
+      case 'k':
+        khz = atoi(optarg);
+        break;
+      case 'n':
+        polls = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-k kHz] [-n polls]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  spi_init(SPI_PORT, khz * 1000);
+  host_virtual_time = true;
+  psx_pad_model_attach(&pad);
+  printf("pad: SPI %u kHz, %d polls per scenario\n", khz, polls);
+
+  scenario_digital();
+  scenario_analog();
+  scenario_pressure();
+  scenario_ds1_pressure();
+  scenario_disconnect();
+  scenario_ack_timing();
+  scenario_id_change();
+  scenario_bit_errors();
+  scenario_input_hold();
+
+  printf("pad: %d failure(s)\n", failures);
+  return failures == 0 ? 0 : 1;
+}
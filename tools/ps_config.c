@@ -0,0 +1,194 @@
+/*
+    Settings tool (Linux hidraw)
+
+    Reads / changes the converter settings (settings.h) over the vendor
+    HID reports, without reflashing.
+
+    build: gcc -O2 -o ps_config ps_config.c
+    usage: ./ps_config /dev/hidrawN get
+           ./ps_config /dev/hidrawN set interval=8 deadzone=4 ...
+           ./ps_config /dev/hidrawN save | defaults | reload
+           ./ps_config /dev/hidrawN status
+*/
+
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "../recovery.h"
+#include "../settings.h"
+
+static const char *layout_name[] = {"mode_pin", "procon", "taiko"};
+
+static int get_settings(int fd, SETTINGS_t *settings) {
+  uint8_t buf[1 + sizeof(SETTINGS_t)];
+
+  buf[0] = SETTINGS_REPORT_ID;
+  if (ioctl(fd, HIDIOCGFEATURE(sizeof(buf)), buf) < (int)sizeof(buf)) {
+    perror("HIDIOCGFEATURE");
+    return -1;
+  }
+  memcpy(settings, buf + 1, sizeof(SETTINGS_t));
+  if (settings->magic != SETTINGS_MAGIC ||
+      settings->version != SETTINGS_VERSION) {
+    fprintf(stderr, "unsupported settings block (magic %04x version %u)\n",
+            settings->magic, settings->version);
+    return -1;
+  }
+  return 0;
+}
+
+static int set_settings(int fd, const SETTINGS_t *settings) {
+  uint8_t buf[1 + sizeof(SETTINGS_t)];
+
+  buf[0] = SETTINGS_REPORT_ID;
+  memcpy(buf + 1, settings, sizeof(SETTINGS_t));
+  if (ioctl(fd, HIDIOCSFEATURE(sizeof(buf)), buf) < 0) {
+    perror("HIDIOCSFEATURE");
+    return -1;
+  }
+  return 0;
+}
+
+static int send_command(int fd, uint8_t cmd) {
+  uint8_t buf[2] = {SETTINGS_CMD_REPORT_ID, cmd};
+
+  if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+    perror("write");
+    return -1;
+  }
+  return 0;
+}
+
+static int print_status(int fd) {
+  uint8_t buf[1 + sizeof(RECOVERY_STATUS_t)];
+  RECOVERY_STATUS_t status;
+
+  buf[0] = RECOVERY_STATUS_REPORT_ID;
+  if (ioctl(fd, HIDIOCGFEATURE(sizeof(buf)), buf) < (int)sizeof(buf)) {
+    perror("HIDIOCGFEATURE");
+    return -1;
+  }
+  memcpy(&status, buf + 1, sizeof(status));
+  printf("watchdog_resets=%lu\n", (unsigned long)status.watchdog_resets);
+  printf("recovered=%u\n", status.recovered);
+  if (status.recovered) printf("saved_state=%u\n", status.saved_state);
+  return 0;
+}
+
+static void print_settings(const SETTINGS_t *settings) {
+  printf("interval=%u\n", settings->report_interval_ms);
+  printf("layout=%s\n", settings->button_layout <= SETTINGS_LAYOUT_TAIKO
+                            ? layout_name[settings->button_layout]
+                            : "?");
+  printf("spi_khz=%u\n", settings->spi_speed_khz);
+  printf("deadzone=%u\n", settings->stick_deadzone);
+  printf("filter=%u\n", settings->stick_filter);
+  printf("imu=%u\n", settings->imu_mode);
+}
+
+static int parse_setting(SETTINGS_t *settings, const char *arg) {
+  char key[32];
+  const char *eq = strchr(arg, '=');
+  const char *value;
+  long n;
+  unsigned i;
+
+  if (eq == NULL || eq - arg >= (int)sizeof(key)) {
+    return -1;
+  }
+  memcpy(key, arg, eq - arg);
+  key[eq - arg] = '\0';
+  value = eq + 1;
+  n = strtol(value, NULL, 0);
+
+  if (strcmp(key, "interval") == 0) {
+    settings->report_interval_ms = n;
+  } else if (strcmp(key, "spi_khz") == 0) {
+    settings->spi_speed_khz = n;
+  } else if (strcmp(key, "deadzone") == 0) {
+    settings->stick_deadzone = n;
+  } else if (strcmp(key, "filter") == 0) {
+    settings->stick_filter = n;
+  } else if (strcmp(key, "imu") == 0) {
+    settings->imu_mode = n;
+  } else if (strcmp(key, "layout") == 0) {
+    for (i = 0; i < sizeof(layout_name) / sizeof(layout_name[0]); i++) {
+      if (strcmp(value, layout_name[i]) == 0) break;
+    }
+    if (i == sizeof(layout_name) / sizeof(layout_name[0])) return -1;
+    settings->button_layout = i;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s /dev/hidrawN get\n"
+          "       %s /dev/hidrawN set key=value ...\n"
+          "       %s /dev/hidrawN save | defaults | reload\n"
+          "       %s /dev/hidrawN status\n"
+          "keys:  interval=1-50 (ms)  layout=mode_pin|procon|taiko\n"
+          "       spi_khz=50-1000  deadzone=0-127  filter=0|1\n"
+          "       imu=0 (off) | 1 (right stick) | 2 (right stick + R3)\n",
+          name, name, name, name);
+}
+
+int main(int argc, char *argv[]) {
+  SETTINGS_t settings;
+  int fd;
+  int i;
+  int ret = 0;
+
+  if (argc < 3) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  fd = open(argv[1], O_RDWR);
+  if (fd < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  if (strcmp(argv[2], "get") == 0) {
+    ret = get_settings(fd, &settings);
+    if (ret == 0) print_settings(&settings);
+  } else if (strcmp(argv[2], "set") == 0) {
+    ret = get_settings(fd, &settings);
+    for (i = 3; ret == 0 && i < argc; i++) {
+      if (parse_setting(&settings, argv[i]) < 0) {
+        fprintf(stderr, "bad setting: %s\n", argv[i]);
+        ret = -1;
+      }
+    }
+    if (ret == 0) ret = set_settings(fd, &settings);
+    // Invalid blocks are dropped by the converter: read back to confirm
+    if (ret == 0) {
+      usleep(50000);
+      ret = get_settings(fd, &settings);
+      if (ret == 0) print_settings(&settings);
+    }
+  } else if (strcmp(argv[2], "save") == 0) {
+    ret = send_command(fd, SETTINGS_CMD_SAVE);
+  } else if (strcmp(argv[2], "defaults") == 0) {
+    ret = send_command(fd, SETTINGS_CMD_DEFAULTS);
+  } else if (strcmp(argv[2], "reload") == 0) {
+    ret = send_command(fd, SETTINGS_CMD_RELOAD);
+  } else if (strcmp(argv[2], "status") == 0) {
+    ret = print_status(fd);
+  } else {
+    usage(argv[0]);
+    ret = -1;
+  }
+
+  close(fd);
+  return ret == 0 ? 0 : 1;
+}
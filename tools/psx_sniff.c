@@ -0,0 +1,160 @@
+/*
+    PSX bus sniffer client (Linux)
+
+    Reads the capture stream of the PSX_SNIFFER firmware from its vendor
+    bulk endpoint (usbfs, no driver needed) or from a saved capture file,
+    and prints one line per frame.
+
+    build: gcc -O2 -o psx_sniff psx_sniff.c
+    usage: ./psx_sniff /dev/bus/usb/BBB/DDD [-o capture.bin]   (see lsusb)
+           ./psx_sniff -r capture.bin
+*/
+
+#include <fcntl.h>
+#include <linux/usbdevice_fs.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "../psx_sniffer.h"
+
+#define EP_IN 0x81
+#define READ_SIZE 4096
+
+static uint8_t stream[2 * READ_SIZE + sizeof(SNIFFER_HEADER_t) +
+                      2 * SNIFFER_MAX_FRAME_BYTES];
+static size_t stream_len = 0;
+
+static void print_frame(const SNIFFER_HEADER_t *header, const uint8_t *cmd,
+                        const uint8_t *data) {
+  int i;
+
+  printf("%10lu.%03lu ms  #%-5u %5u us  ack %-3u",
+         (unsigned long)(header->time_us / 1000),
+         (unsigned long)(header->time_us % 1000), header->seq,
+         header->duration_us, header->ack_count);
+  for (i = 0; i < header->length; i++) printf(" %02x", cmd[i]);
+  printf("  |");
+  for (i = 0; i < header->length; i++) printf(" %02x", data[i]);
+  if (header->flags & SNIFFER_FLAG_TRUNCATED) printf("  (truncated)");
+  if (header->flags & SNIFFER_FLAG_NO_START) printf("  (no start)");
+  printf("\n");
+}
+
+static void print_stats(const SNIFFER_HEADER_t *header,
+                        const SNIFFER_STATS_t *stats) {
+  printf("%10lu.%03lu ms  stats: frames %lu, usb dropped %lu, "
+         "ring overruns %lu, unmatched %lu, ring high water %lu words\n",
+         (unsigned long)(header->time_us / 1000),
+         (unsigned long)(header->time_us % 1000),
+         (unsigned long)stats->frames, (unsigned long)stats->usb_dropped,
+         (unsigned long)stats->ring_overruns, (unsigned long)stats->unmatched,
+         (unsigned long)stats->ring_high_water);
+}
+
+// Decode complete records, keep the remainder for the next call
+static void decode(void) {
+  size_t pos = 0;
+
+  while (stream_len - pos >= sizeof(SNIFFER_HEADER_t)) {
+    SNIFFER_HEADER_t header;
+    size_t payload;
+
+    if (stream[pos] != SNIFFER_SYNC0 || stream[pos + 1] != SNIFFER_SYNC1) {
+      pos++;  // resync
+      continue;
+    }
+    memcpy(&header, &stream[pos], sizeof(header));
+
+    if (header.type == SNIFFER_REC_FRAME &&
+        header.length <= SNIFFER_MAX_FRAME_BYTES) {
+      payload = 2 * header.length;
+    } else if (header.type == SNIFFER_REC_STATS &&
+               header.length == sizeof(SNIFFER_STATS_t)) {
+      payload = header.length;
+    } else {
+      pos++;
+      continue;
+    }
+    if (stream_len - pos < sizeof(header) + payload) break;
+
+    const uint8_t *body = &stream[pos + sizeof(header)];
+    if (header.type == SNIFFER_REC_FRAME) {
+      print_frame(&header, body, body + header.length);
+    } else {
+      SNIFFER_STATS_t stats;
+      memcpy(&stats, body, sizeof(stats));
+      print_stats(&header, &stats);
+    }
+    pos += sizeof(header) + payload;
+  }
+
+  memmove(stream, &stream[pos], stream_len - pos);
+  stream_len -= pos;
+  fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+  const char *out_path = NULL;
+  FILE *out = NULL;
+  bool from_file = false;
+  int fd;
+  int n;
+
+  if (argc == 3 && strcmp(argv[1], "-r") == 0) {
+    from_file = true;
+    argv[1] = argv[2];
+  } else if (argc == 4 && strcmp(argv[2], "-o") == 0) {
+    out_path = argv[3];
+  } else if (argc != 2) {
+    fprintf(stderr,
+            "usage: %s /dev/bus/usb/BBB/DDD [-o capture.bin]\n"
+            "       %s -r capture.bin\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  fd = open(argv[1], from_file ? O_RDONLY : O_RDWR);
+  if (fd < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  if (out_path != NULL && (out = fopen(out_path, "wb")) == NULL) {
+    perror(out_path);
+    return 1;
+  }
+
+  if (!from_file) {
+    unsigned int itf = 0;
+    if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &itf) < 0) {
+      perror("USBDEVFS_CLAIMINTERFACE");
+      return 1;
+    }
+  }
+
+  while (1) {
+    uint8_t *buf = &stream[stream_len];
+
+    if (from_file) {
+      n = read(fd, buf, READ_SIZE);
+      if (n <= 0) break;
+    } else {
+      struct usbdevfs_bulktransfer bulk = {
+          .ep = EP_IN, .len = READ_SIZE, .timeout = 2000, .data = buf};
+      n = ioctl(fd, USBDEVFS_BULK, &bulk);
+      if (n < 0) {
+        perror("USBDEVFS_BULK");  // timeout: the firmware sends stats
+        break;                    // every second, so the link is gone
+      }
+    }
+    if (out != NULL) fwrite(buf, 1, n, out);
+    stream_len += n;
+    decode();
+  }
+
+  if (out != NULL) fclose(out);
+  close(fd);
+  return 0;
+}
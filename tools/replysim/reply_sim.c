@@ -0,0 +1,136 @@
+/*
+    Switch subcommand reply queue under backpressure, native run (Linux)
+
+    Runs sw_host_command() / sw_tx_task() from sw_controller.c on the host
+    shim. The IN endpoint is held busy (host_hid_ready) while the host sends
+    more commands than the reply queue holds; once it is free again, every
+    reply must go out exactly once, in command order, before input frames,
+    and the side effects of held commands (IMU enable) must apply.
+
+    usage: ./reply_sim
+    exit status is non-zero when a scenario does not behave as expected
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_shim.h"
+#include "sw_controller.h"
+
+#define MAX_REPLIES 64
+
+static int failures = 0;
+static uint8_t packet_counter = 0;
+
+static void report(const char *name, bool ok, const char *note) {
+  printf("reply: %-16s %s", name, ok ? "ok  " : "FAIL");
+  if (note != NULL) printf("  (%s)", note);
+  printf("\n");
+  if (!ok) failures++;
+}
+
+// 0x01 subcommand OUT report
+static void send_subcommand(uint8_t subcmd, const uint8_t *args, int len) {
+  uint8_t buf[SW_REPORT_SIZE];
+
+  memset(buf, 0, sizeof(buf));
+  buf[0] = 0x01;
+  buf[1] = packet_counter++ & 0x0f;
+  buf[10] = subcmd;
+  memcpy(&buf[11], args, len);
+  sw_host_command(buf, sizeof(buf));
+}
+
+static void send_spi_read(uint16_t addr, uint8_t len) {
+  uint8_t args[5] = {addr & 0xff, addr >> 8, 0, 0, len};
+
+  send_subcommand(0x10, args, sizeof(args));
+}
+
+// Run sw_tx_task() until nothing more is sent; collect 0x21 replies as
+// subcmd << 16 | first two data bytes (SPI address)
+static int drain(uint32_t *replies, int max, int *inputs) {
+  uint32_t count = host_hid_report_count;
+  int n = 0;
+  int i;
+
+  *inputs = 0;
+  for (i = 0; i < 1000; i++) {
+    sw_tx_task();
+    if (host_hid_report_count == count) continue;
+    count = host_hid_report_count;
+    if (host_hid_report_id == 0x30) {
+      (*inputs)++;
+    } else if (host_hid_report_id == 0x21 && n < max) {
+      replies[n++] = host_hid_report[13] << 16 | host_hid_report[14] |
+                     host_hid_report[15] << 8;
+    }
+  }
+  return n;
+}
+
+// More SPI reads than the reply queue holds while the endpoint is busy
+static void scenario_overflow(void) {
+  const int commands = 14;  // > queue, within queue + hold
+  uint32_t replies[MAX_REPLIES];
+  uint32_t overflow = sw_tx_overflow_count();
+  int inputs, n, i;
+  bool in_order = true;
+  char note[64];
+
+  host_hid_ready = false;
+  for (i = 0; i < commands; i++) {
+    send_spi_read(0x6000 + i * 0x10, 0x10);
+    sw_queue_input();
+    sw_tx_task();
+  }
+  host_hid_ready = true;
+  n = drain(replies, MAX_REPLIES, &inputs);
+
+  for (i = 0; i < n; i++) {
+    if (replies[i] != (0x10u << 16 | (0x6000 + i * 0x10))) in_order = false;
+  }
+  snprintf(note, sizeof(note), "%d commands, %d replies, %d input frames",
+           commands, n, inputs);
+  report("overflow", n == commands && in_order && inputs == 1 &&
+                         sw_tx_overflow_count() == overflow, note);
+}
+
+// Session setup held behind a full queue still takes effect, in order
+static void scenario_held_setup(void) {
+  static const uint8_t imu_on[] = {0x01};
+  static const uint8_t full_mode[] = {0x30};
+  uint8_t imu[SW_IMU_SIZE];
+  uint32_t replies[MAX_REPLIES];
+  int inputs, n, i;
+  bool ok;
+
+  host_hid_ready = false;
+  for (i = 0; i < 10; i++) send_spi_read(0x6000 + i * 0x10, 0x10);
+  send_subcommand(0x03, full_mode, sizeof(full_mode));
+  send_subcommand(0x40, imu_on, sizeof(imu_on));
+  host_hid_ready = true;
+  n = drain(replies, MAX_REPLIES, &inputs);
+  ok = n == 12 && (replies[10] >> 16) == 0x03 && (replies[11] >> 16) == 0x40;
+
+  // IMU block now follows the input in 0x30 reports
+  for (i = 0; i < SW_IMU_SIZE; i++) imu[i] = i + 1;
+  sw_update_imu(imu);
+  sw_queue_input();
+  sw_tx_task();
+  ok = ok && host_hid_report_id == 0x30 &&
+       memcmp(&host_hid_report[1 + SW_INPUT_STATE_SIZE], imu, sizeof(imu)) ==
+           0;
+  report("held setup", ok, "0x03 / 0x40 behind 10 SPI reads, IMU enabled");
+}
+
+int main(void) {
+  init_sw_module();
+  sw_tx_reset();
+
+  scenario_overflow();
+  scenario_held_setup();
+
+  if (failures) printf("%d scenario(s) failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+/*
+    Virtual-clock simulator of the firmware main loop
+
+    Models the interaction of tud_task()/hid_task() pacing, PSX transfer
+    time and the host IN endpoint polling phase, and reports how old the
+    pad sample is when the host reads it (sample age) and the spacing of
+    new reports seen by the host (inter-report jitter).
+
+    Everything runs on a virtual microsecond clock driven by a seeded PRNG,
+    so a given command line always gives the same result.
+
+    build: gcc -O2 -o loop_sim loop_sim.c -lm
+    usage: ./loop_sim [options]
+      -p policy   fixed | oversample | jit | ready   (default fixed)
+                    fixed      : firmware Switch mode (board_millis() tick,
+                                 poll pad, queue report)
+                    oversample : fixed tick, sticks also sampled every
+                                 STICK_OVERSAMPLE_INTERVAL_US between ticks
+                    jit        : poll the pad just before the host frame
+                                 in which the report is due
+                    ready      : PC mode (poll + report whenever the
+                                 endpoint is free)
+      -i ms       report interval (default SW_REPORT_INTERVAL_MS = 12)
+      -b bytes    PSX transaction length incl. header (default 9: analog)
+      -k khz      PSX SPI clock (default 250)
+      -a us       pad ACK delay max (default 12, min is a/2)
+      -f us       host polling interval (default 1000: bInterval 1 at FS)
+      -j us       host polling jitter (default 0)
+      -d ppm      host clock drift against the device clock (default 100)
+      -P us       host polling phase (default: random)
+      -l us       main loop overhead per iteration (default 5)
+      -t s        simulated time (default 60)
+      -s seed     PRNG seed (default 1)
+      -c          print every host read as CSV (time,age,interval)
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../stick_filter.h"
+
+//--------------------------------------------------------------------+
+// Parameters
+//--------------------------------------------------------------------+
+typedef enum { POLICY_FIXED, POLICY_OVERSAMPLE, POLICY_JIT, POLICY_READY } policy_t;
+
+typedef struct {
+  policy_t policy;
+  uint32_t interval_ms;
+  uint32_t psx_bytes;
+  uint32_t spi_khz;
+  uint32_t ack_us;
+  uint32_t host_interval_us;
+  uint32_t host_jitter_us;
+  int32_t host_drift_ppm;
+  int64_t host_phase_us;  // < 0: random
+  uint32_t loop_us;
+  uint32_t sim_s;
+  uint32_t seed;
+  int csv;
+} params_t;
+
+//--------------------------------------------------------------------+
+// PRNG (xorshift32, deterministic)
+//--------------------------------------------------------------------+
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint32_t rng_range(uint32_t min, uint32_t max) {
+  return (max <= min) ? min : min + rng() % (max - min + 1);
+}
+
+//--------------------------------------------------------------------+
+// Models
+//--------------------------------------------------------------------+
+
+// Pad: one get_psx_pad_data() call (blocking, like the firmware)
+static uint64_t pad_transfer_us(const params_t *p) {
+  uint64_t us = 5;  // CS setup
+  uint32_t byte_us = (8 * 1000 + p->spi_khz - 1) / p->spi_khz;
+  uint32_t i;
+
+  for (i = 0; i < p->psx_bytes; i++) {
+    us += byte_us;
+    if (i != p->psx_bytes - 1) {
+      us += rng_range(p->ack_us / 2, p->ack_us);
+    }
+  }
+  return us;
+}
+
+// Worst case of pad_transfer_us()
+static uint64_t pad_transfer_max_us(const params_t *p) {
+  uint32_t byte_us = (8 * 1000 + p->spi_khz - 1) / p->spi_khz;
+  return 5 + (uint64_t)p->psx_bytes * byte_us +
+         (uint64_t)(p->psx_bytes - 1) * p->ack_us;
+}
+
+// Host: IN endpoint polled once per interval (+ drift, jitter)
+// Host SOF and the device timer run from different crystals, so the
+// polling phase slowly walks against board_millis() ticks.
+static uint64_t host_next_poll(const params_t *p, uint64_t frame) {
+  uint64_t nominal = frame * p->host_interval_us;
+  uint64_t t = nominal + (uint64_t)p->host_phase_us +
+               (int64_t)((double)nominal * p->host_drift_ppm / 1e6);
+  if (p->host_jitter_us) {
+    t += rng_range(0, p->host_jitter_us);
+  }
+  return t;
+}
+
+//--------------------------------------------------------------------+
+// Statistics
+//--------------------------------------------------------------------+
+typedef struct {
+  uint32_t *values;
+  size_t count;
+  size_t capacity;
+} series_t;
+
+static void series_add(series_t *s, uint32_t v) {
+  if (s->count == s->capacity) {
+    s->capacity = s->capacity ? s->capacity * 2 : 1024;
+    s->values = realloc(s->values, s->capacity * sizeof(uint32_t));
+  }
+  s->values[s->count++] = v;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void series_print(const char *name, series_t *s) {
+  double sum = 0, sq = 0;
+  size_t i;
+
+  if (s->count == 0) {
+    printf("%-16s no data\n", name);
+    return;
+  }
+  for (i = 0; i < s->count; i++) {
+    sum += s->values[i];
+    sq += (double)s->values[i] * s->values[i];
+  }
+  double mean = sum / s->count;
+  double sd = sqrt(sq / s->count - mean * mean);
+
+  qsort(s->values, s->count, sizeof(uint32_t), cmp_u32);
+  printf("%-16s n=%zu min=%u p50=%u p90=%u p99=%u max=%u mean=%.1f sd=%.1f us\n",
+         name, s->count, s->values[0], s->values[s->count / 2],
+         s->values[s->count * 9 / 10], s->values[s->count * 99 / 100],
+         s->values[s->count - 1], mean, sd);
+}
+
+//--------------------------------------------------------------------+
+// Simulation
+//--------------------------------------------------------------------+
+typedef struct {
+  int full;            // report waiting in the IN endpoint
+  uint64_t queued_us;  // tud_hid_report() time
+  uint64_t sample_us;  // pad sample (transfer start) in that report
+} endpoint_t;
+
+static void simulate(const params_t *p) {
+  const uint64_t end_us = (uint64_t)p->sim_s * 1000000;
+  const uint64_t interval_us = (uint64_t)p->interval_ms * 1000;
+  series_t age = {0}, gap = {0};
+  endpoint_t ep = {0};
+  uint64_t t = 0;
+  uint64_t frame = 0;
+  uint64_t next_poll = host_next_poll(p, frame);
+  uint64_t last_read_us = 0;
+  uint64_t tick_start_ms = 0;
+  uint64_t next_oversample_us = 0;
+  uint64_t jit_due_us = interval_us;  // POLICY_JIT: next report due
+  int have_read = 0;
+
+  while (t < end_us) {
+    // Host polls that happened up to now (endpoint is serviced by hardware)
+    while (next_poll <= t) {
+      if (ep.full && ep.queued_us <= next_poll) {
+        uint32_t a = (uint32_t)(next_poll - ep.sample_us);
+        series_add(&age, a);
+        if (have_read) {
+          series_add(&gap, (uint32_t)(next_poll - last_read_us));
+        }
+        if (p->csv) {
+          printf("%llu,%u,%llu\n", (unsigned long long)next_poll, a,
+                 have_read ? (unsigned long long)(next_poll - last_read_us)
+                           : 0ull);
+        }
+        last_read_us = next_poll;
+        have_read = 1;
+        ep.full = 0;
+      }
+      next_poll = host_next_poll(p, ++frame);
+    }
+
+    // One main loop iteration: tud_task() + hid_task()
+    t += p->loop_us;
+
+    switch (p->policy) {
+      case POLICY_FIXED:
+      case POLICY_OVERSAMPLE: {
+        uint64_t now_ms = t / 1000;  // board_millis()
+        if (now_ms - tick_start_ms < p->interval_ms) {
+          // Extra pad transfers between ticks delay the next tick
+          if (p->policy == POLICY_OVERSAMPLE && t >= next_oversample_us) {
+            next_oversample_us = t + STICK_OVERSAMPLE_INTERVAL_US;
+            t += pad_transfer_us(p);
+          }
+          break;
+        }
+        tick_start_ms += p->interval_ms;
+        // input_response(): poll pad, queue report
+        uint64_t sample = t;
+        t += pad_transfer_us(p);
+        if (!ep.full) {
+          ep.full = 1;
+          ep.queued_us = t;
+          ep.sample_us = sample;
+        }
+      } break;
+
+      case POLICY_JIT: {
+        // Report due at the first host frame after each interval boundary;
+        // start the pad transfer so that it ends right before that frame
+        uint64_t due_frame = next_poll;
+        uint64_t f = frame;
+        while (due_frame < jit_due_us) {
+          due_frame = host_next_poll(p, ++f);
+        }
+        if (t + pad_transfer_max_us(p) + p->loop_us < due_frame) {
+          break;  // too early
+        }
+        uint64_t sample = t;
+        t += pad_transfer_us(p);
+        if (!ep.full) {
+          ep.full = 1;
+          ep.queued_us = t;
+          ep.sample_us = sample;
+        }
+        jit_due_us += interval_us;
+      } break;
+
+      case POLICY_READY:
+        // PC mode: endpoint free -> poll pad, report
+        if (!ep.full) {
+          uint64_t sample = t;
+          t += pad_transfer_us(p);
+          ep.full = 1;
+          ep.queued_us = t;
+          ep.sample_us = sample;
+        }
+        break;
+    }
+  }
+
+  if (!p->csv) {
+    series_print("sample age", &age);
+    series_print("report interval", &gap);
+  }
+  free(age.values);
+  free(gap.values);
+}
+
+int main(int argc, char *argv[]) {
+  params_t p = {POLICY_FIXED, 12, 9, 250, 12, 1000, 0, 100, -1, 5, 60, 1, 0};
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    const char *opt = argv[i];
+    const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (strcmp(opt, "-c") == 0) {
+      p.csv = 1;
+      continue;
+    }
+    if (val == NULL) {
+      fprintf(stderr, "missing value for %s\n", opt);
+      return 1;
+    }
+    i++;
+    if (strcmp(opt, "-p") == 0) {
+      if (strcmp(val, "fixed") == 0) p.policy = POLICY_FIXED;
+      else if (strcmp(val, "oversample") == 0) p.policy = POLICY_OVERSAMPLE;
+      else if (strcmp(val, "jit") == 0) p.policy = POLICY_JIT;
+      else if (strcmp(val, "ready") == 0) p.policy = POLICY_READY;
+      else {
+        fprintf(stderr, "unknown policy %s\n", val);
+        return 1;
+      }
+    } else if (strcmp(opt, "-i") == 0) p.interval_ms = atoi(val);
+    else if (strcmp(opt, "-b") == 0) p.psx_bytes = atoi(val);
+    else if (strcmp(opt, "-k") == 0) p.spi_khz = atoi(val);
+    else if (strcmp(opt, "-a") == 0) p.ack_us = atoi(val);
+    else if (strcmp(opt, "-f") == 0) p.host_interval_us = atoi(val);
+    else if (strcmp(opt, "-j") == 0) p.host_jitter_us = atoi(val);
+    else if (strcmp(opt, "-d") == 0) p.host_drift_ppm = atoi(val);
+    else if (strcmp(opt, "-P") == 0) p.host_phase_us = atoi(val);
+    else if (strcmp(opt, "-l") == 0) p.loop_us = atoi(val);
+    else if (strcmp(opt, "-t") == 0) p.sim_s = atoi(val);
+    else if (strcmp(opt, "-s") == 0) p.seed = atoi(val);
+    else {
+      fprintf(stderr, "unknown option %s\n", opt);
+      return 1;
+    }
+  }
+  if (p.interval_ms == 0 || p.spi_khz == 0 || p.host_interval_us == 0 ||
+      p.loop_us == 0 || p.psx_bytes == 0) {
+    fprintf(stderr, "invalid parameter\n");
+    return 1;
+  }
+
+  rng_state = p.seed ? p.seed : 1;
+  if (p.host_phase_us < 0) {
+    p.host_phase_us = rng() % p.host_interval_us;
+  }
+
+  simulate(&p);
+  return 0;
+}
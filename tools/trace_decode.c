@@ -0,0 +1,83 @@
+/*
+    Trace log decoder (Linux)
+
+    Decodes the binary trace stream written by trace_log.c (TRACE_LOG build)
+    from a serial port or a capture file.
+
+    build: gcc -O2 -o trace_decode trace_decode.c
+    usage: stty -F /dev/ttyUSB0 115200 raw
+           ./trace_decode /dev/ttyUSB0
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../trace_log.h"
+
+static const char *event_name(uint16_t id) {
+  switch (id) {
+    case TRACE_EV_PSX_POLL_START:
+      return "psx_poll_start";
+    case TRACE_EV_PSX_POLL_END:
+      return "psx_poll_end";
+    case TRACE_EV_PSX_ACK_TIMEOUT:
+      return "psx_ack_timeout";
+    case TRACE_EV_HOST_DATA:
+      return "host_data";
+    case TRACE_EV_REPORT_SENT:
+      return "report_sent";
+    case TRACE_EV_HID_NOT_READY:
+      return "hid_not_ready";
+    case TRACE_EV_SW_STATE:
+      return "sw_state";
+    case TRACE_EV_DROPPED:
+      return "dropped";
+    default:
+      return "unknown";
+  }
+}
+
+int main(int argc, char *argv[]) {
+  FILE *fp = stdin;
+  TRACE_RECORD_t record;
+  uint32_t last_us = 0;
+  int c;
+  int sync = 0;
+
+  if (argc > 1) {
+    fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  while ((c = fgetc(fp)) != EOF) {
+    // Wait for sync bytes
+    if (sync == 0) {
+      sync = (c == TRACE_SYNC0);
+      continue;
+    }
+    if (c != TRACE_SYNC1) {
+      sync = (c == TRACE_SYNC0);
+      continue;
+    }
+    sync = 0;
+
+    if (fread(&record, sizeof(record), 1, fp) != 1) {
+      break;
+    }
+
+    printf("%10u us  %+8d  %-16s %5u  %u\n", record.time_us,
+           (int32_t)(record.time_us - last_us), event_name(record.id),
+           record.arg0, record.arg1);
+    last_us = record.time_us;
+  }
+
+  if (fp != stdin) {
+    fclose(fp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+/*
+    Binary trace log (drain side)
+*/
+
+#include "trace_log.h"
+
+#include <string.h>
+
+#ifdef TRACE_LOG
+
+#include "hardware/uart.h"
+
+#define TRACE_UART uart0
+
+TRACE_RECORD_t trace_buffer[TRACE_BUFFER_SIZE];
+volatile uint32_t trace_head = 0;
+volatile uint32_t trace_tail = 0;
+uint32_t trace_dropped = 0;
+
+// Record being sent (sync + record), kept across calls
+static uint8_t tx_frame[2 + sizeof(TRACE_RECORD_t)];
+static uint8_t tx_pos = sizeof(tx_frame);
+
+static uint32_t reported_dropped = 0;
+
+// Send as many bytes as the UART FIFO accepts, never blocks
+void trace_drain(void) {
+  while (uart_is_writable(TRACE_UART)) {
+    if (tx_pos == sizeof(tx_frame)) {
+      TRACE_RECORD_t record;
+
+      if (trace_dropped != reported_dropped) {
+        reported_dropped = trace_dropped;
+        record.time_us = time_us_32();
+        record.id = TRACE_EV_DROPPED;
+        record.arg0 = 0;
+        record.arg1 = reported_dropped;
+      } else if (trace_tail != trace_head) {
+        record = trace_buffer[trace_tail & (TRACE_BUFFER_SIZE - 1)];
+        trace_tail = trace_tail + 1;
+      } else {
+        return;
+      }
+
+      tx_frame[0] = TRACE_SYNC0;
+      tx_frame[1] = TRACE_SYNC1;
+      memcpy(tx_frame + 2, &record, sizeof(record));
+      tx_pos = 0;
+    }
+    uart_putc_raw(TRACE_UART, tx_frame[tx_pos++]);
+  }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary trace log
+// Fixed-size records are written to a RAM ring on the hot path and drained
+// to the stdio UART (GPIO0) when the main loop is idle.
+// Decode with tools/trace_decode.
+// The UART carries only trace records: the options that printf on it
+// cannot be enabled at the same time.
+
+// Event IDs
+#define TRACE_EV_PSX_POLL_START 0x01
+#define TRACE_EV_PSX_POLL_END 0x02     // arg0: pad ID, arg1: result
+#define TRACE_EV_PSX_ACK_TIMEOUT 0x03  // arg0: byte index
+#define TRACE_EV_HOST_DATA 0x04        // arg0: command, arg1: subcommand
+#define TRACE_EV_REPORT_SENT 0x05      // arg0: report ID, arg1: timer byte
+#define TRACE_EV_HID_NOT_READY 0x06    // arg0: report ID waiting (once)
+#define TRACE_EV_SW_STATE 0x07         // arg0: new SW_STATE_t
+#define TRACE_EV_DROPPED 0x08          // arg1: records dropped so far
+
+// Wire format: TRACE_SYNC0 TRACE_SYNC1 + TRACE_RECORD_t (little endian)
+#define TRACE_SYNC0 0xa5
+#define TRACE_SYNC1 0x5a
+
+typedef struct __attribute__((packed)) {
+  uint32_t time_us;
+  uint16_t id;
+  uint16_t arg0;
+  uint32_t arg1;
+} TRACE_RECORD_t;
+
+#ifdef TRACE_LOG
+
+#if defined(BOOT_TIMING) || defined(HOT_PATH_TIMING) || \
+    defined(STICK_FILTER_BENCH) || defined(KERNEL_BENCH)
+#error "TRACE_LOG shares the stdio UART with printf output options"
+#endif
+
+#include "pico/stdlib.h"
+
+#define TRACE_BUFFER_SIZE 256  // records, must be power of 2
+
+extern TRACE_RECORD_t trace_buffer[TRACE_BUFFER_SIZE];
+extern volatile uint32_t trace_head;
+extern volatile uint32_t trace_tail;
+extern uint32_t trace_dropped;
+
+static inline void trace_event(uint16_t id, uint16_t arg0, uint32_t arg1) {
+  uint32_t head = trace_head;
+
+  if (head - trace_tail >= TRACE_BUFFER_SIZE) {
+    trace_dropped++;
+    return;
+  }
+
+  TRACE_RECORD_t *record = &trace_buffer[head & (TRACE_BUFFER_SIZE - 1)];
+  record->time_us = time_us_32();
+  record->id = id;
+  record->arg0 = arg0;
+  record->arg1 = arg1;
+  trace_head = head + 1;
+}
+
+#define TRACE(id, arg0, arg1) trace_event((id), (arg0), (arg1))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void trace_drain(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+
+#define TRACE(id, arg0, arg1) \
+  do {                        \
+  } while (0)
+#define trace_drain() \
+  do {                \
+  } while (0)
+
+#endif
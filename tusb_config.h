@@ -100,11 +100,19 @@ extern "C" {
 #define CFG_TUD_MSC 0
 #define CFG_TUD_HID 1
 #define CFG_TUD_MIDI 0
+#ifdef PSX_SNIFFER
+#define CFG_TUD_VENDOR 1
+#else
 #define CFG_TUD_VENDOR 0
+#endif
 
 // HID buffer size Should be sufficient to hold ID (if any) + Data
 #define CFG_TUD_HID_EP_BUFSIZE 64
 
+// Vendor FIFO size: absorbs capture bursts while the host is busy
+#define CFG_TUD_VENDOR_RX_BUFSIZE 64
+#define CFG_TUD_VENDOR_TX_BUFSIZE 4096
+
 #ifdef __cplusplus
 }
 #endif
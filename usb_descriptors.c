@@ -23,6 +23,7 @@
  *
  */
 
+#include "pc_controller.h"
 #include "tusb.h"
 
 /* A combination of interfaces must have a unique product id, since PC will save
@@ -37,6 +38,13 @@
   (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(HID, 2) | \
    _PID_MAP(MIDI, 3) | _PID_MAP(VENDOR, 4))
 
+// VID of the PC gamepad / sniffer devices. 0xCafe is TinyUSB's example VID
+// and only a placeholder: set your own with cmake -DUSB_VID=0x1234.
+// (Pro Controller mode always uses Nintendo's VID/PID.)
+#ifndef USB_VID
+#define USB_VID 0xCafe
+#endif
+
 //--------------------------------------------------------------------+
 // Device Descriptors
 //--------------------------------------------------------------------+
@@ -59,9 +67,59 @@ tusb_desc_device_t const desc_device = {
 
     .bNumConfigurations = 0x01};
 
+// Generic HID gamepad (PC host)
+tusb_desc_device_t const desc_device_pc = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00,
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+
+    .iManufacturer = 0x01,
+    .iProduct = 0x02,
+    .iSerialNumber = 0x00,
+
+    .bNumConfigurations = 0x01};
+
+#ifdef PSX_SNIFFER
+// Passive PSX bus capture (vendor bulk interface)
+tusb_desc_device_t const desc_device_sniffer = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00,
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+
+    .iManufacturer = 0x01,
+    .iProduct = 0x02,
+    .iSerialNumber = 0x00,
+
+    .bNumConfigurations = 0x01};
+#endif
+
 // Invoked when received GET DEVICE DESCRIPTOR
 // Application return pointer to descriptor
 uint8_t const* tud_descriptor_device_cb(void) {
+  if (g_usb_mode == USB_MODE_PC) {
+    return (uint8_t const*)&desc_device_pc;
+  }
+#ifdef PSX_SNIFFER
+  if (g_usb_mode == USB_MODE_SNIFFER) {
+    return (uint8_t const*)&desc_device_sniffer;
+  }
+#endif
   return (uint8_t const*)&desc_device;
 }
 
@@ -180,11 +238,85 @@ uint8_t const desc_hid_report[] = {
 };
 // TUD_HID_REPORT_DESC_GENERIC_INOUT(CFG_TUD_HID_EP_BUFSIZE)
 
+// HID Descriptor for generic gamepad (PC_REPORT_t)
+uint8_t const desc_hid_report_pc[] = {
+    0x05, 0x01,  // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x05,  // Usage (Game Pad)
+    0xA1, 0x01,  // Collection (Application)
+    0x85, 0x01,  //   Report ID (1)  .. PC_REPORT_ID
+    0x05, 0x09,  //   Usage Page (Button)
+    0x19, 0x01,  //   Usage Minimum (0x01)
+    0x29, 0x0C,  //   Usage Maximum (0x0C)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x01,  //   Logical Maximum (1)
+    0x75, 0x01,  //   Report Size (1)
+    0x95, 0x0C,  //   Report Count (12)
+    0x81, 0x02,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null
+                 //   Position)
+    0x05, 0x01,  //   Usage Page (Generic Desktop Ctrls)
+    0x09, 0x39,  //   Usage (Hat switch)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x25, 0x07,  //   Logical Maximum (7)
+    0x35, 0x00,  //   Physical Minimum (0)
+    0x46, 0x3B, 0x01,  //   Physical Maximum (315)
+    0x65, 0x14,  //   Unit (System: English Rotation, Length: Centimeter)
+    0x75, 0x04,  //   Report Size (4)
+    0x95, 0x01,  //   Report Count (1)
+    0x81, 0x42,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,Null
+                 //   State)
+    0x65, 0x00,  //   Unit (None)
+    0x09, 0x30,  //   Usage (X)
+    0x09, 0x31,  //   Usage (Y)
+    0x09, 0x32,  //   Usage (Z)
+    0x09, 0x35,  //   Usage (Rz)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x75, 0x08,  //   Report Size (8)
+    0x95, 0x04,  //   Report Count (4)
+    0x81, 0x02,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null
+                 //   Position)
+    0x06, 0x00, 0xFF,  //   Usage Page (Vendor Defined 0xFF00)
+    0x19, 0x01,  //   Usage Minimum (0x01)
+    0x29, 0x0C,  //   Usage Maximum (0x0C)
+    0x95, 0x0C,  //   Report Count (12)  .. DS2 pressure
+    0x81, 0x02,  //   Input (Data,Var,Abs,No Wrap,Linear,Preferred State,No Null
+                 //   Position)
+    0xC0,        // End Collection
+
+    // Settings / status channel (PC mode only: the Switch descriptor above
+    // must stay the same as a real Pro Controller's)
+    0x06, 0x00, 0xFF,  // Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x01,  // Usage (0x01)
+    0xA1, 0x01,  // Collection (Application)
+    0x15, 0x00,  //   Logical Minimum (0)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x85, 0xF0,  //   Report ID (-16)  .. SETTINGS_REPORT_ID
+    0x09, 0x07,  //   Usage (0x07)
+    0x75, 0x08,  //   Report Size (8)
+    0x95, 0x10,  //   Report Count (16)  .. sizeof(SETTINGS_t)
+    0xB1, 0x02,  //   Feature (Data,Var,Abs,No Wrap,Linear,Preferred State,No
+                 //   Null Position,Non-volatile)
+    0x85, 0xF1,  //   Report ID (-15)  .. SETTINGS_CMD_REPORT_ID
+    0x09, 0x08,  //   Usage (0x08)
+    0x95, 0x01,  //   Report Count (1)
+    0x91, 0x02,  //   Output (Data,Var,Abs,No Wrap,Linear,Preferred State,No
+                 //   Null Position,Non-volatile)
+    0x85, 0xF2,  //   Report ID (-14)  .. RECOVERY_STATUS_REPORT_ID
+    0x09, 0x09,  //   Usage (0x09)
+    0x95, 0x08,  //   Report Count (8)  .. sizeof(RECOVERY_STATUS_t)
+    0xB1, 0x03,  //   Feature (Const,Var,Abs,No Wrap,Linear,Preferred State,No
+                 //   Null Position,Non-volatile)
+    0xC0,        // End Collection
+};
+
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const* tud_hid_descriptor_report_cb(uint8_t itf) {
   (void)itf;
+  if (g_usb_mode == USB_MODE_PC) {
+    return desc_hid_report_pc;
+  }
   return desc_hid_report;
 }
 
@@ -209,11 +341,46 @@ uint8_t const desc_configuration[] = {
                              sizeof(desc_hid_report), EPNUM_HID,
                              0x80 | EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 1)};
 
+#define CONFIG_PC_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+
+uint8_t const desc_configuration_pc[] = {
+    // Config number, interface count, string index, total length, attribute,
+    // power in mA
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_PC_TOTAL_LEN, 0xa0, 500),
+
+    // Interface number, string index, protocol, report descriptor len, EP In
+    // address, size & polling interval
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_report_pc), 0x80 | EPNUM_HID,
+                       CFG_TUD_HID_EP_BUFSIZE, PC_REPORT_INTERVAL_MS)};
+
+#ifdef PSX_SNIFFER
+#define CONFIG_SNIFFER_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN)
+
+uint8_t const desc_configuration_sniffer[] = {
+    // Config number, interface count, string index, total length, attribute,
+    // power in mA
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_SNIFFER_TOTAL_LEN, 0x80,
+                          100),
+
+    // Interface 0 is the vendor interface in this mode
+    // Interface number, string index, EP Out & In address, size
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_HID, 0, EPNUM_HID, 0x80 | EPNUM_HID, 64)};
+#endif
+
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const* tud_descriptor_configuration_cb(uint8_t index) {
   (void)index;  // for multiple configurations
+  if (g_usb_mode == USB_MODE_PC) {
+    return desc_configuration_pc;
+  }
+#ifdef PSX_SNIFFER
+  if (g_usb_mode == USB_MODE_SNIFFER) {
+    return desc_configuration_sniffer;
+  }
+#endif
   return desc_configuration;
 }
 
@@ -229,6 +396,20 @@ char const* string_desc_arr[] = {
     "000000000001",              // 3: Serials, should use chip ID
 };
 
+char const* string_desc_arr_pc[] = {
+    (const char[]){0x09, 0x04},  // 0: is supported language is English (0x0409)
+    "PSX_SWitch",                // 1: Manufacturer
+    "PSX Gamepad",               // 2: Product
+    "000000000001",              // 3: Serials, should use chip ID
+};
+
+char const* string_desc_arr_sniffer[] = {
+    (const char[]){0x09, 0x04},  // 0: is supported language is English (0x0409)
+    "PSX_SWitch",                // 1: Manufacturer
+    "PSX Bus Sniffer",           // 2: Product
+    "000000000001",              // 3: Serials, should use chip ID
+};
+
 static uint16_t _desc_str[32];
 
 // Invoked when received GET STRING DESCRIPTOR request
@@ -246,10 +427,17 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
     // Note: the 0xEE index string is a Microsoft OS 1.0 Descriptors.
     // https://docs.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-defined-usb-descriptors
 
+    char const** desc_arr = string_desc_arr;
+    if (g_usb_mode == USB_MODE_PC) {
+      desc_arr = string_desc_arr_pc;
+    } else if (g_usb_mode == USB_MODE_SNIFFER) {
+      desc_arr = string_desc_arr_sniffer;
+    }
+
     if (!(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0])))
       return NULL;
 
-    const char* str = string_desc_arr[index];
+    const char* str = desc_arr[index];
 
     // Cap at max char
     chr_count = strlen(str);